@@ -0,0 +1,167 @@
+#include "RelationViewStateStore.h"
+
+#include <QtCore/QByteArray>
+#include <QtCore/QCoreApplication>
+#include <QtCore/QFile>
+#include <QtCore/QJsonArray>
+#include <QtCore/QJsonDocument>
+#include <QtCore/QJsonObject>
+#include <QtCore/QSaveFile>
+#include <QtCore/QString>
+#include <QtCore/QTimer>
+
+#include <fbsdk/fbsdk.h>
+
+#include "ConfigReadWriter.h"
+
+const static std::string STATE_FILE_NAME = "RelationConstraintDialogViewStates.json";
+
+std::filesystem::path RelationViewStateStore::stateFilePath()
+{
+    // Place the file next to the config file
+    return ConfigReadWriter::configFilePath().parent_path() / STATE_FILE_NAME;
+}
+
+bool RelationViewStateStore::lookup(const std::string &scenePath, const std::string &relationName, QPoint &outTopLeftPos, double &outScaleFactor)
+{
+    if (scenePath.empty())
+        return false;
+
+    std::lock_guard<std::mutex> lock(mMutex);
+    loadIfRequired();
+
+    auto sceneIt = mScenes.find(scenePath);
+    if (sceneIt == mScenes.end())
+        return false;
+
+    auto relationIt = sceneIt->second.find(relationName);
+    if (relationIt == sceneIt->second.end())
+        return false;
+
+    outTopLeftPos = relationIt->second.topLeftPos;
+    outScaleFactor = relationIt->second.scaleFactor;
+    return true;
+}
+
+void RelationViewStateStore::store(const std::string &scenePath, const std::string &relationName, QPoint topLeftPos, double scaleFactor)
+{
+    if (scenePath.empty() || relationName.empty())
+        return;
+
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        // Read the file first, so the states of the other scenes are not lost when writing
+        loadIfRequired();
+
+        ViewState &state = mScenes[scenePath][relationName];
+        state.topLeftPos = topLeftPos;
+        state.scaleFactor = scaleFactor;
+        mIsDirty = true;
+    }
+
+    QCoreApplication *application = QCoreApplication::instance();
+    if (!application || mIsFlushScheduled.exchange(true))
+        return;
+
+    // Batch the changes made until the timer fires into one write
+    // Note: The timer must be started in the main thread, so queue it to the event loop
+    QMetaObject::invokeMethod(application, [this, application]()
+                              { QTimer::singleShot(flushDelayMs, application, [this]()
+                                                   { writeChanges(false); }); }, Qt::QueuedConnection);
+}
+
+void RelationViewStateStore::flush()
+{
+    writeChanges(true);
+}
+
+void RelationViewStateStore::loadIfRequired()
+{
+    if (mIsLoaded)
+        return;
+
+    mIsLoaded = true;
+
+    QFile file(QString::fromStdString(stateFilePath().string()));
+    if (!file.open(QIODevice::ReadOnly))
+        return;
+
+    QJsonDocument document = QJsonDocument::fromJson(file.readAll());
+    QJsonObject scenes = document.object().value("scenes").toObject();
+
+    for (auto sceneIt = scenes.begin(); sceneIt != scenes.end(); ++sceneIt)
+    {
+        RelationViewStates &states = mScenes[sceneIt.key().toStdString()];
+
+        QJsonObject relations = sceneIt.value().toObject();
+        for (auto relationIt = relations.begin(); relationIt != relations.end(); ++relationIt)
+        {
+            // Each state is stored as [x, y, scale] to keep the file compact
+            QJsonArray values = relationIt.value().toArray();
+            if (values.size() != 3)
+                continue;
+
+            ViewState &state = states[relationIt.key().toStdString()];
+            state.topLeftPos = QPoint(values[0].toInt(), values[1].toInt());
+            state.scaleFactor = values[2].toDouble(1.0);
+        }
+    }
+}
+
+void RelationViewStateStore::writeChanges(bool waitForCompletion)
+{
+    mIsFlushScheduled = false;
+
+    QByteArray data;
+    {
+        std::lock_guard<std::mutex> lock(mMutex);
+
+        if (!mIsDirty)
+        {
+            if (waitForCompletion)
+            {
+                std::lock_guard<std::mutex> writeLock(mWriteMutex);
+                if (mPendingWrite.valid())
+                    mPendingWrite.wait();
+            }
+
+            return;
+        }
+
+        QJsonObject scenes;
+        for (const auto &scene : mScenes)
+        {
+            QJsonObject relations;
+            for (const auto &relation : scene.second)
+                relations.insert(QString::fromStdString(relation.first),
+                                 QJsonArray{relation.second.topLeftPos.x(), relation.second.topLeftPos.y(), relation.second.scaleFactor});
+
+            scenes.insert(QString::fromStdString(scene.first), relations);
+        }
+
+        QJsonObject root;
+        root.insert("version", 1);
+        root.insert("scenes", scenes);
+
+        data = QJsonDocument(root).toJson(QJsonDocument::Compact);
+        mIsDirty = false;
+    }
+
+    std::lock_guard<std::mutex> writeLock(mWriteMutex);
+
+    // Wait for the previous write, so the file is written in order
+    if (mPendingWrite.valid())
+        mPendingWrite.wait();
+
+    QString filePath = QString::fromStdString(stateFilePath().string());
+    mPendingWrite = std::async(std::launch::async, [filePath, data]()
+                               {
+                                   // QSaveFile replaces the file only when all the data is written
+                                   QSaveFile file(filePath);
+                                   if (!file.open(QIODevice::WriteOnly) || file.write(data) != data.size() || !file.commit())
+                                       FBTrace("Relation Constraint Dialog: Failed to write the relation view states to '%s'.\n", filePath.toUtf8().constData()); });
+
+    if (waitForCompletion)
+        mPendingWrite.wait();
+}
\ No newline at end of file
@@ -0,0 +1,107 @@
+#pragma once
+
+#include <atomic>
+#include <filesystem>
+#include <future>
+#include <mutex>
+#include <string>
+#include <unordered_map>
+
+#include <QtCore/QPoint>
+
+/**
+ * @class RelationViewStateStore
+ * @brief Singleton class that persists the relation view states (pan and scale) across sessions
+ * @details The states are stored in a compact JSON file in the user's config directory, keyed by the scene file path
+ *          and the relation constraint name. The file is read once when a state is first looked up, and written
+ *          asynchronously in batches a while after the last change.
+ */
+class RelationViewStateStore
+{
+public:
+    /**
+     * @brief Get the singleton instance of RelationViewStateStore
+     * @return Reference to the singleton instance
+     */
+    static RelationViewStateStore &getInstance()
+    {
+        static RelationViewStateStore instance;
+        return instance;
+    }
+
+    /**
+     * @brief Get the defined path to the view state file
+     * @return The path where the view state file is expected to be located
+     */
+    static std::filesystem::path stateFilePath();
+
+    /**
+     * @brief Look up the stored view state of a relation constraint
+     * @param scenePath The file path of the scene
+     * @param relationName The name of the relation constraint
+     * @param outTopLeftPos Output parameter to receive the top-left position of the relation view
+     * @param outScaleFactor Output parameter to receive the scale factor of the relation view
+     * @return true if a state is found, false otherwise
+     */
+    bool lookup(const std::string &scenePath, const std::string &relationName, QPoint &outTopLeftPos, double &outScaleFactor);
+
+    /**
+     * @brief Store the view state of a relation constraint and schedule writing the file
+     * @param scenePath The file path of the scene, ignored if empty (the scene has never been saved)
+     * @param relationName The name of the relation constraint
+     * @param topLeftPos The top-left position of the relation view
+     * @param scaleFactor The scale factor of the relation view
+     * @note Changes made within flushDelayMs are written to the file at once. This can be called from any thread.
+     */
+    void store(const std::string &scenePath, const std::string &relationName, QPoint topLeftPos, double scaleFactor);
+
+    /**
+     * @brief Write the pending changes to the file and wait for the completion
+     * @note This is called when the application is exiting.
+     */
+    void flush();
+
+private:
+    /// @cond
+    RelationViewStateStore() = default;
+    RelationViewStateStore(const RelationViewStateStore &) = delete;
+    RelationViewStateStore &operator=(const RelationViewStateStore &) = delete;
+    /// @endcond
+
+    /**
+     * @brief Read the file into mScenes if it has not been read yet
+     * @note mMutex must be locked by the caller.
+     */
+    void loadIfRequired();
+
+    /**
+     * @brief Serialize the pending changes and write them to the file in a background thread
+     * @param waitForCompletion If true, wait until the file is written
+     */
+    void writeChanges(bool waitForCompletion);
+
+private:
+    /**
+     * @struct ViewState
+     * @brief Stored state of the relation view
+     */
+    struct ViewState
+    {
+        QPoint topLeftPos = {0, 0}; //!< Top-left position of the relation view
+        double scaleFactor = 1.0;   //!< Scale factor of the relation view
+    };
+
+    /// View states for each relation constraint name
+    using RelationViewStates = std::unordered_map<std::string, ViewState>;
+
+    static constexpr int flushDelayMs = 2000; //!< Delay in milliseconds from the first pending change to writing the file
+
+    std::mutex mMutex;                                          //!< Mutex to protect access to mScenes, mIsLoaded and mIsDirty
+    std::unordered_map<std::string, RelationViewStates> mScenes; //!< View states for each scene file path
+    bool mIsLoaded = false;                                     //!< Flag indicating that the file has been read
+    bool mIsDirty = false;                                      //!< Flag indicating that mScenes has changes not written yet
+
+    std::atomic<bool> mIsFlushScheduled = false; //!< Flag to coalesce the changes into one write
+    std::mutex mWriteMutex;                      //!< Mutex to serialize the writes of the file
+    std::future<void> mPendingWrite;             //!< Background write in progress
+};
\ No newline at end of file
@@ -1,26 +1,23 @@
 #include "CustomEventFilters.h"
 #include "GLHooks.h"
+#include "NavigatorRegistry.h"
 #include "RelationDialogManager.h"
 #include "SearchDialog.h"
 #include "Utility.h"
 
 #include <array>
+#include <atomic>
+#include <cmath>
+#include <functional>
+#include <memory>
 
-#include <QtCore/QSet>
+#include <QtCore/QPointer>
 #include <QtCore/QTimer>
 #include <QtGui/QCursor>
 #include <QtGui/QKeyEvent>
 #include <QtWidgets/QDockWidget>
 #include <QtWidgets/QMainWindow>
 
-#include <windows.h>
-#include <gl/GL.h>
-#include <gl/GLU.h>
-
-#ifndef GL_DRAW_FRAMEBUFFER_BINDING
-#define GL_DRAW_FRAMEBUFFER_BINDING 0x8CA6
-#endif
-
 /**
  * @brief The spacing between grid lines in the relation view
  * @note This value is constant, even when the relation view is scaled.
@@ -28,29 +25,27 @@
  */
 constexpr double relationViewGridSpacing = 40.0;
 
-bool installNavigatorConstraintFilters()
+/**
+ * @brief Maximum time in milliseconds to wait for the next relation view frame
+ * @note The relation view is not redrawn if nothing has changed (e.g. 'A' is pressed while the view is already framed),
+ *       so the waiting function is run anyway after this time.
+ */
+constexpr int relationViewFrameWaitTimeoutMs = 250;
+
+QList<QDockWidget *> installNavigatorConstraintFilters()
 {
-    // Gather all constraint navigators (both floating and docked)
-    QList<QDockWidget *> allNavigators;
-    allNavigators.append(getFloatingConstraintNavigators());
-    allNavigators.append(getDockedConstraintNavigators());
+    // Register all constraint navigators (both floating and docked)
+    // Note: The registry avoids duplicate entries
+    QList<QDockWidget *> allNavigators = NavigatorRegistry::getInstance().refresh();
 
     if (allNavigators.isEmpty())
     {
         DIALOG_DEBUG_MESSAGE("No Constraints Navigator found at this time.");
-        return false;
+        return allNavigators;
     }
 
-    // Use QSet to avoid duplicate entries
-#if QT_VERSION_MAJOR == 5 && QT_VERSION_MINOR == 12
-    // QSet constructor accepts two iterators is not available in Qt 5.12.5
-    QSet<QDockWidget *> uniqueNavigators = QSet<QDockWidget *>::fromList(allNavigators);
-#else
-    QSet<QDockWidget *> uniqueNavigators(allNavigators.begin(), allNavigators.end());
-#endif
-
     // Install NavigatorConstraint Filters
-    for (QDockWidget *navigator : uniqueNavigators)
+    for (QDockWidget *navigator : allNavigators)
     {
         QByteArray windowTitle = navigator->windowTitle().toUtf8();
         DIALOG_DEBUG_MESSAGE("Found Constraints Navigator: '%s'", windowTitle.constData());
@@ -58,37 +53,68 @@ bool installNavigatorConstraintFilters()
         DIALOG_DEBUG_MESSAGE("Constraints Navigator Filter successfully installed.");
     }
 
-    return true;
+    return allNavigators;
 }
 
-static double getHookedLastGridSpacing(QOpenGLWidget *widget)
+/**
+ * @brief Helper function to get the framebuffer used by the relation view shown in the QOpenGLWidget
+ * @param widget The QOpenGLWidget which shows the relation view
+ * @return The framebuffer ID, or -1 if widget is nullptr
+ * @note QOpenGLWidget::defaultFramebufferObject() returns the handle held by the widget,
+ *       so the context does not need to be made current.
+ */
+static GLint getRelationViewFramebuffer(QOpenGLWidget *widget)
 {
     if (!widget)
-        return getLastGridSpacing(-1);
-
-    widget->makeCurrent();
-
-    GLint framebuffer;
-    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+        return -1;
 
-    widget->doneCurrent();
-
-    return getLastGridSpacing(framebuffer);
+    return static_cast<GLint>(widget->defaultFramebufferObject());
 }
 
-static std::array<double, 4> getHookedBoxRectRange(QOpenGLWidget *widget)
+/**
+ * @brief Helper function to run a function in the event loop right after the next relation view frame is completed
+ * @param widget The QOpenGLWidget to wait for, or nullptr to wait for any relation view
+ * @param context The QObject in whose thread the function is run. The function is discarded if it is destroyed.
+ * @param function The function to run once
+ */
+static void runAfterNextRelationViewFrame(QOpenGLWidget *widget, QObject *context, std::function<void()> function)
 {
-    if (!widget)
-        return getBoxRectRange(-1);
+    auto isDone = std::make_shared<std::atomic<bool>>(false);
 
-    widget->makeCurrent();
+    auto runOnce = [isDone, function]()
+    {
+        if (!isDone->exchange(true))
+            function();
+    };
 
-    GLint framebuffer;
-    glGetIntegerv(GL_DRAW_FRAMEBUFFER_BINDING, &framebuffer);
+    // The hooks call back in the middle of the rendering, so queue the function to the event loop
+    QPointer<QObject> guardedContext(context);
+    auto queueOnFrameCompleted = [guardedContext, runOnce](GLint)
+    {
+        if (guardedContext)
+            QMetaObject::invokeMethod(guardedContext.data(), runOnce, Qt::QueuedConnection);
+    };
 
-    widget->doneCurrent();
+    const RelationViewFrameCallbackId callbackId = requestNextRelationViewFrameCallback(getRelationViewFramebuffer(widget), queueOnFrameCompleted);
 
-    return getBoxRectRange(framebuffer);
+    // Stop waiting for the frame on timeout, e.g. when the view is closed, even if the context has been destroyed
+    auto onTimeout = [callbackId, guardedContext, runOnce]()
+    {
+        cancelRelationViewFrameCallback(callbackId);
+        if (guardedContext)
+            runOnce();
+    };
+    QTimer::singleShot(relationViewFrameWaitTimeoutMs, QCoreApplication::instance(), onTimeout);
+}
+
+static double getHookedLastGridSpacing(QOpenGLWidget *widget)
+{
+    return getLastGridSpacing(getRelationViewFramebuffer(widget));
+}
+
+static std::array<double, 4> getHookedBoxRectRange(QOpenGLWidget *widget)
+{
+    return getBoxRectRange(getRelationViewFramebuffer(widget));
 }
 
 /**
@@ -98,37 +124,24 @@ static std::array<double, 4> getHookedBoxRectRange(QOpenGLWidget *widget)
  * @param outRelationViewPos The output relation view coordinates
  * @param scaleFactor The scale factor to apply to the unprojected coordinates (default is 1.0)
  * @return true if unprojection is successful, false otherwise
+ * @note The transform captured by the GL hooks at draw time is used, so no context switch happens here.
  */
 static bool unprojectGLWidgetToRelationView(QOpenGLWidget *widget, const QPoint &localCursorPos, QPoint &outRelationViewPos, double scaleFactor = 1.0)
 {
     if (!widget)
         return false;
 
-    widget->makeCurrent();
-
-    GLint viewport[4];
-    glGetIntegerv(GL_VIEWPORT, viewport);
-
-    GLdouble modelview[16], projection[16];
-    glGetDoublev(GL_MODELVIEW_MATRIX, modelview);
-    glGetDoublev(GL_PROJECTION_MATRIX, projection);
-
-    double relationViewPosX, relationViewPosY, _relationViewPosZ;
-    if (gluUnProject(localCursorPos.x(), viewport[3] - localCursorPos.y(), 0.0, modelview, projection, viewport,
-                     &relationViewPosX, &relationViewPosY, &_relationViewPosZ))
-    {
-        double scaleGLToRelation = relationViewGridSpacing / defaultGLGridSpacing * scaleFactor;
-        double relationViewPosScaledX = std::round(relationViewPosX * scaleGLToRelation);
-        double relationViewPosScaledY = std::round(relationViewPosY * scaleGLToRelation);
+    double relationViewPosX, relationViewPosY;
+    if (!unprojectRelationView(getRelationViewFramebuffer(widget), localCursorPos.x(), localCursorPos.y(),
+                               relationViewPosX, relationViewPosY))
+        return false;
 
-        outRelationViewPos = QPoint(relationViewPosScaledX, relationViewPosScaledY);
+    double scaleGLToRelation = relationViewGridSpacing / defaultGLGridSpacing * scaleFactor;
+    double relationViewPosScaledX = std::round(relationViewPosX * scaleGLToRelation);
+    double relationViewPosScaledY = std::round(relationViewPosY * scaleGLToRelation);
 
-        widget->doneCurrent();
-        return true;
-    }
-
-    widget->doneCurrent();
-    return false;
+    outRelationViewPos = QPoint(relationViewPosScaledX, relationViewPosScaledY);
+    return true;
 }
 
 /**
@@ -142,6 +155,9 @@ static bool consumeTabKeyShortcutOverrideEvent(QOpenGLWidget *widget, QKeyEvent
 {
     if (widget && keyEvent && widget->underMouse())
     {
+        // Measure the latency to the first paint of the dialog from here, where the Tab key press is handled
+        SearchDialog::getInstance()->startOpenLatencyTimer();
+
         QPoint localCursorPos = widget->mapFromGlobal(QCursor::pos());
         double scaleFactor = defaultGLGridSpacing / getHookedLastGridSpacing(widget);
         QPoint relationViewPosTemp;
@@ -154,8 +170,10 @@ static bool consumeTabKeyShortcutOverrideEvent(QOpenGLWidget *widget, QKeyEvent
             return false;
         }
 
-        QPoint relationViewPos = RelationDialogManager::getInstance().getRelationViewTopLeftPos() + relationViewPosTemp;
-        FBConstraintRelation *selectedConstraint = RelationDialogManager::getInstance().getLastSelectedRelationConstraint();
+        // Read the relation and its view state from the same snapshot to keep them consistent
+        RelationViewSnapshotPtr snapshot = RelationDialogManager::getInstance().getRelationViewSnapshot(widget);
+        QPoint relationViewPos = snapshot->topLeftPos + relationViewPosTemp;
+        FBConstraintRelation *selectedConstraint = snapshot->getRelation();
 
         /**
          * @note If only one box is positioned far away from the origin (0,0), the 'framing' function of the relation view
@@ -175,11 +193,9 @@ static bool consumeTabKeyShortcutOverrideEvent(QOpenGLWidget *widget, QKeyEvent
             }
         }
 
-        // Create the SearchDialog with the calculated position and retrieved constraint
-        SearchDialog *lDialog = new SearchDialog(QCursor::pos(), relationViewPos, selectedConstraint);
-
-        // Show the dialog at the cursor position
-        lDialog->show();
+        // Reset the prewarmed SearchDialog with the calculated position and retrieved constraint,
+        // and show it at the cursor position
+        SearchDialog::getInstance()->openAt(QCursor::pos(), relationViewPos, selectedConstraint);
 
         return true; // Event should be consumed
     }
@@ -202,19 +218,16 @@ bool MainWindowFilter::eventFilter(QObject *obj, QEvent *pEvent)
     // Do not use QEvent::ChildAdded because windowTitle might not be initialized
     if (pEvent->type() == QEvent::ChildPolished)
     {
-        DIALOG_DEBUG_START;
-        DIALOG_DEBUG_MESSAGE("Child Widget creation detected in MainWindow.");
+        mChildPolishedEventCount++;
 
-        if (installNavigatorConstraintFilters())
+        // Layout switches and scene loads send hundreds of ChildPolished events,
+        // so coalesce them into one discovery pass in the next event loop turn
+        if (!mIsDiscoveryPending)
         {
-            // Notify RelationDialogManager to install the RelationOpenGLWidgetFilter
-            // Use a short delay to ensure the relation view is fully initialized
-            QTimer::singleShot(50, []()
-                               { RelationDialogManager::getInstance().setFilterInstallRequired(); });
-            DIALOG_DEBUG_END_SUCCESS;
+            mIsDiscoveryPending = true;
+            QMetaObject::invokeMethod(this, [this]()
+                                      { runNavigatorDiscovery(); }, Qt::QueuedConnection);
         }
-        else
-            DIALOG_DEBUG_END_NOTFAILURE;
 
         // Avoid this event to be processed further
         pEvent->accept();
@@ -227,25 +240,14 @@ bool MainWindowFilter::eventFilter(QObject *obj, QEvent *pEvent)
     {
         QKeyEvent *keyEvent = static_cast<QKeyEvent *>(pEvent);
 
-        QOpenGLWidget *widget = nullptr;
-
-        // Gather all constraint navigators (both floating and docked)
-        QList<QDockWidget *> allNavigators;
-        allNavigators.append(getFloatingConstraintNavigators());
-        allNavigators.append(getDockedConstraintNavigators(mainwindow));
+        // ShortcutOverride is sent for every key press, so check the key before looking for the relation view
+        if (keyEvent->isAutoRepeat() || (keyEvent->key() != Qt::Key_Tab && keyEvent->key() != Qt::Key_A))
+            return false;
 
         // Find the QOpenGLWidget under the mouse cursor
-        for (QDockWidget *navigator : allNavigators)
-        {
-            QOpenGLWidget *currentWidget = navigator->findChild<QOpenGLWidget *>();
-            if (currentWidget && currentWidget->underMouse())
-            {
-                widget = currentWidget;
-                break;
-            }
-        }
+        QOpenGLWidget *widget = NavigatorRegistry::getInstance().getRelationViewUnderMouse();
 
-        if (keyEvent->key() == Qt::Key_Tab && !keyEvent->isAutoRepeat())
+        if (keyEvent->key() == Qt::Key_Tab)
         {
             if (consumeTabKeyShortcutOverrideEvent(widget, keyEvent))
             {
@@ -253,14 +255,15 @@ bool MainWindowFilter::eventFilter(QObject *obj, QEvent *pEvent)
                 return true;
             }
         }
-        else if (keyEvent->key() == Qt::Key_A && !keyEvent->isAutoRepeat())
+        else if (keyEvent->key() == Qt::Key_A)
         {
             if (!widget)
                 return false;
 
-            // Emit signal after a short delay to wait for relation view to be completely changed
-            QTimer::singleShot(50, [this, widget]()
-                               { emit keyAPressed(widget); });
+            // Emit signal after the next frame of the relation view, when the view has been completely changed
+            QPointer<QOpenGLWidget> guardedWidget(widget);
+            runAfterNextRelationViewFrame(widget, this, [this, guardedWidget]()
+                                          { if (guardedWidget) emit keyAPressed(guardedWidget); });
 
             pEvent->accept();
             return true;
@@ -271,6 +274,35 @@ bool MainWindowFilter::eventFilter(QObject *obj, QEvent *pEvent)
     return false;
 }
 
+void MainWindowFilter::runNavigatorDiscovery()
+{
+    mIsDiscoveryPending = false;
+    mDiscoveryPassCount++;
+
+    DIALOG_DEBUG_START;
+    DIALOG_DEBUG_MESSAGE("Child Widget creation detected in MainWindow.");
+
+    const QList<QDockWidget *> navigators = installNavigatorConstraintFilters();
+    if (!navigators.isEmpty())
+    {
+        // Notify RelationDialogManager to install the RelationOpenGLWidgetFilter on the navigators just found
+        // Wait for a relation view frame to ensure the relation view is fully initialized
+        runAfterNextRelationViewFrame(nullptr, this, [navigators]()
+                                      { RelationDialogManager::getInstance().setFilterInstallRequired(navigators); });
+        DIALOG_DEBUG_END_SUCCESS;
+    }
+    else
+        DIALOG_DEBUG_END_NOTFAILURE;
+}
+
+void MainWindowFilter::traceNavigatorDiscoveryReport()
+{
+    DIALOG_DEBUG_START;
+    DIALOG_DEBUG_MESSAGE("Navigator discovery passes: %llu, ChildPolished events: %llu, scans avoided: %llu",
+                         mDiscoveryPassCount, mChildPolishedEventCount, mChildPolishedEventCount - mDiscoveryPassCount);
+    DIALOG_DEBUG_END_NOTFAILURE;
+}
+
 ConstraintsNavigatorFilter::ConstraintsNavigatorFilter(QObject *parent) : QObject(parent)
 {
     connect(this, &ConstraintsNavigatorFilter::keyAPressed, &RelationOpenGLWidgetFilter::getInstance(), &RelationOpenGLWidgetFilter::onKeyAPressed);
@@ -282,10 +314,13 @@ bool ConstraintsNavigatorFilter::eventFilter(QObject *obj, QEvent *pEvent)
     {
         QKeyEvent *keyEvent = static_cast<QKeyEvent *>(pEvent);
 
-        QOpenGLWidget *widget = obj->findChild<QOpenGLWidget *>();
-
         // The same logic as in MainWindowFilter::eventFilter
-        if (keyEvent->key() == Qt::Key_Tab && !keyEvent->isAutoRepeat())
+        if (keyEvent->isAutoRepeat() || (keyEvent->key() != Qt::Key_Tab && keyEvent->key() != Qt::Key_A))
+            return false;
+
+        QOpenGLWidget *widget = NavigatorRegistry::getInstance().getRelationView(qobject_cast<QDockWidget *>(obj));
+
+        if (keyEvent->key() == Qt::Key_Tab)
         {
             if (consumeTabKeyShortcutOverrideEvent(widget, keyEvent))
             {
@@ -293,13 +328,14 @@ bool ConstraintsNavigatorFilter::eventFilter(QObject *obj, QEvent *pEvent)
                 return true;
             }
         }
-        else if (keyEvent->key() == Qt::Key_A && !keyEvent->isAutoRepeat())
+        else if (keyEvent->key() == Qt::Key_A)
         {
             if (!widget || !widget->underMouse())
                 return false;
 
-            QTimer::singleShot(50, [this, widget]()
-                               { emit keyAPressed(widget); });
+            QPointer<QOpenGLWidget> guardedWidget(widget);
+            runAfterNextRelationViewFrame(widget, this, [this, guardedWidget]()
+                                          { if (guardedWidget) emit keyAPressed(guardedWidget); });
 
             pEvent->accept();
             return true;
@@ -310,8 +346,38 @@ bool ConstraintsNavigatorFilter::eventFilter(QObject *obj, QEvent *pEvent)
     return false;
 }
 
+void RelationOpenGLWidgetFilter::trackRelationView(QOpenGLWidget *widget)
+{
+    if (!widget || !mDragStates.emplace(widget, DragState()).second)
+        return;
+
+    // Remove the states of the relation view when the widget is destroyed
+    connect(widget, &QObject::destroyed, this, [this, widget]()
+            {
+                mDragStates.erase(widget);
+                RelationDialogManager::getInstance().removeRelationView(widget); });
+}
+
+void RelationOpenGLWidgetFilter::untrackRelationViews()
+{
+    for (const auto &dragState : mDragStates)
+        disconnect(dragState.first, &QObject::destroyed, this, nullptr);
+
+    mDragStates.clear();
+}
+
 bool RelationOpenGLWidgetFilter::eventFilter(QObject *obj, QEvent *pEvent)
 {
+    if (pEvent->type() != QEvent::MouseButtonPress && pEvent->type() != QEvent::MouseButtonRelease)
+        return false;
+
+    QOpenGLWidget *widget = qobject_cast<QOpenGLWidget *>(obj);
+    auto dragStateIt = mDragStates.find(widget);
+    if (dragStateIt == mDragStates.end())
+        return false;
+
+    DragState &dragState = dragStateIt->second;
+
     if (pEvent->type() == QEvent::MouseButtonPress)
     {
         QMouseEvent *mouseEvent = static_cast<QMouseEvent *>(pEvent);
@@ -321,15 +387,15 @@ bool RelationOpenGLWidgetFilter::eventFilter(QObject *obj, QEvent *pEvent)
         {
             if (mouseEvent->modifiers() & Qt::ShiftModifier)
             {
-                mIsDragging = true;
-                mDragStartPosition = mouseEvent->pos();
-                mCurrentDragMode = DragMode::Translate;
+                dragState.mIsDragging = true;
+                dragState.mDragStartPosition = mouseEvent->pos();
+                dragState.mCurrentDragMode = DragMode::Translate;
             }
             else if (mouseEvent->modifiers() & Qt::ControlModifier)
             {
-                mIsDragging = true;
-                mDragStartPosition = mouseEvent->pos();
-                mCurrentDragMode = DragMode::Scale;
+                dragState.mIsDragging = true;
+                dragState.mDragStartPosition = mouseEvent->pos();
+                dragState.mCurrentDragMode = DragMode::Scale;
             }
             else
                 return false;
@@ -337,50 +403,52 @@ bool RelationOpenGLWidgetFilter::eventFilter(QObject *obj, QEvent *pEvent)
     }
 
     // Detect Drag End with Left Mouse Button release
-    if (pEvent->type() == QEvent::MouseButtonRelease && mIsDragging)
+    if (pEvent->type() == QEvent::MouseButtonRelease && dragState.mIsDragging)
     {
-        double scaleFactor = defaultGLGridSpacing / getHookedLastGridSpacing(qobject_cast<QOpenGLWidget *>(obj));
+        // The new state is calculated from this snapshot, and stored only if it has not been replaced in the meantime
+        RelationViewSnapshotPtr snapshot = RelationDialogManager::getInstance().getRelationViewSnapshot(widget);
+        double scaleFactor = defaultGLGridSpacing / getHookedLastGridSpacing(widget);
 
-        if (mCurrentDragMode == DragMode::Translate)
+        if (dragState.mCurrentDragMode == DragMode::Translate)
         {
             // Calculate the drag vector in the UI
             QMouseEvent *mouseEvent = static_cast<QMouseEvent *>(pEvent);
             QPoint dragEndPosition = mouseEvent->pos();
-            QPoint dragVectorInGLWidget = dragEndPosition - mDragStartPosition;
+            QPoint dragVectorInGLWidget = dragEndPosition - dragState.mDragStartPosition;
 
             // Calculate the translate offset in relation view coordinates
             QPoint relationViewTopLeftPosOffset;
-            if (unprojectGLWidgetToRelationView(qobject_cast<QOpenGLWidget *>(obj), (-1) * dragVectorInGLWidget, relationViewTopLeftPosOffset, scaleFactor))
+            if (unprojectGLWidgetToRelationView(widget, (-1) * dragVectorInGLWidget, relationViewTopLeftPosOffset, scaleFactor))
             {
                 // Get the current top-left position of the relation view and apply the offset
-                QPoint currentTopLeftPos = RelationDialogManager::getInstance().getRelationViewTopLeftPos();
+                QPoint currentTopLeftPos = snapshot->topLeftPos;
                 currentTopLeftPos += relationViewTopLeftPosOffset;
 
                 // Update the relation view state
-                RelationDialogManager::getInstance().setRelationViewState(currentTopLeftPos, scaleFactor);
+                RelationDialogManager::getInstance().compareAndSetRelationViewState(widget, snapshot, currentTopLeftPos, scaleFactor);
             }
         }
 
-        else if (mCurrentDragMode == DragMode::Scale)
+        else if (dragState.mCurrentDragMode == DragMode::Scale)
         {
             // Calculate the drag start position in relation view coordinates
             QPoint dragStartPosInRelationView;
-            if (unprojectGLWidgetToRelationView(qobject_cast<QOpenGLWidget *>(obj), mDragStartPosition, dragStartPosInRelationView))
+            if (unprojectGLWidgetToRelationView(widget, dragState.mDragStartPosition, dragStartPosInRelationView))
             {
                 // Get the current relation view state
-                double lastScaleFactor = RelationDialogManager::getInstance().getLastRelationViewScaleFactor();
-                QPoint currentTopLeftPos = RelationDialogManager::getInstance().getRelationViewTopLeftPos();
+                double lastScaleFactor = snapshot->scaleFactor;
+                QPoint currentTopLeftPos = snapshot->topLeftPos;
 
                 // Calculate the scale offset and apply it to the top-left position
                 currentTopLeftPos += (lastScaleFactor - scaleFactor) * dragStartPosInRelationView;
 
                 // Update the relation view state
-                RelationDialogManager::getInstance().setRelationViewState(currentTopLeftPos, scaleFactor);
+                RelationDialogManager::getInstance().compareAndSetRelationViewState(widget, snapshot, currentTopLeftPos, scaleFactor);
             }
         }
 
         // Reset the dragging flag
-        mIsDragging = false;
+        dragState.mIsDragging = false;
     }
 
     return false;
@@ -418,7 +486,8 @@ void RelationOpenGLWidgetFilter::onKeyAPressed(QOpenGLWidget *widget)
     if (!widget)
         return;
 
-    FBConstraintRelation *relation = RelationDialogManager::getInstance().getLastSelectedRelationConstraint();
+    RelationViewSnapshotPtr snapshot = RelationDialogManager::getInstance().getRelationViewSnapshot(widget);
+    FBConstraintRelation *relation = snapshot->getRelation();
     if (!relation)
         return;
 
@@ -440,13 +509,13 @@ void RelationOpenGLWidgetFilter::onKeyAPressed(QOpenGLWidget *widget)
 
             // Get previous top-left position of the relation view
             QPoint topLeft;
-            getRelationBoxRectTopLeft(RelationDialogManager::getInstance().getLastSelectedRelationConstraint(), topLeft);
+            getRelationBoxRectTopLeft(relation, topLeft);
 
             // Calculate the new center position in the relation view coordinates
             QPoint currentWorldCenter = topLeft + centerFromTopLeft;
 
             // Update the relation view state
-            RelationDialogManager::getInstance().setRelationViewState(currentWorldCenter - viewportCenterInRelationView, scaleFactor);
+            RelationDialogManager::getInstance().compareAndSetRelationViewState(widget, snapshot, currentWorldCenter - viewportCenterInRelationView, scaleFactor);
         }
     }
     else
@@ -458,7 +527,7 @@ void RelationOpenGLWidgetFilter::onKeyAPressed(QOpenGLWidget *widget)
         {
             // The new center position will be about (0,0) in relation view coordinates.
             // Update the relation view state
-            RelationDialogManager::getInstance().setRelationViewState((-1) * viewportCenterInRelationView, 1.0);
+            RelationDialogManager::getInstance().compareAndSetRelationViewState(widget, snapshot, (-1) * viewportCenterInRelationView, 1.0);
         }
     }
 }
\ No newline at end of file
@@ -1,10 +1,14 @@
 #pragma once
 
+#include <unordered_map>
+
 #include <QtCore/QEvent>
+#include <QtCore/QList>
 #include <QtCore/QObject>
 #include <QtCore/QPoint>
 #include <QtCore/QtConfig>
 #include <QtWidgets/QApplication>
+#include <QtWidgets/QDockWidget>
 
 #if QT_VERSION_MAJOR >= 6
 #include <QtOpenGLWidgets/QOpenGLWidget>
@@ -16,11 +20,11 @@
 
 /**
  * @brief Install the ConstraintsNavigatorFilter on all existing navigator windows (both floating and docked)
- * @return true if at least one navigator window was found and filter installed, false otherwise
+ * @return The navigator windows found and filtered, empty if none
  * @note This function uses DIALOG_DEBUD_MESSAGE to log its operations, so ensure that DIALOG_DEBUG_START is called before this function
  *       and DIALOG_DEBUG_END_SUCCESS/FAILURE/NOTFAILURE is called after this function to properly log the debug messages.
  */
-bool installNavigatorConstraintFilters();
+QList<QDockWidget *> installNavigatorConstraintFilters();
 
 /**
  * @class MainWindowFilter
@@ -57,6 +61,25 @@ protected:
      * @return true if the event is handled and should not be propagated further, false otherwise
      */
     bool eventFilter(QObject *obj, QEvent *pEvent) override;
+
+public:
+    /**
+     * @brief Output the number of navigator discovery passes and the ChildPolished events coalesced into them with FBTrace
+     */
+    static void traceNavigatorDiscoveryReport();
+
+private:
+    /**
+     * @brief Run a navigator discovery pass requested by ChildPolished events
+     * @details Installs the ConstraintsNavigatorFilter on the navigators and requests the RelationOpenGLWidgetFilter installation.
+     *          ChildPolished events received while a pass is pending are coalesced into that pass.
+     */
+    void runNavigatorDiscovery();
+
+private:
+    bool mIsDiscoveryPending = false;                              //!< Flag indicating that a discovery pass is queued to the event loop
+    inline static unsigned long long mChildPolishedEventCount = 0; //!< Number of ChildPolished events received by the filter of the main window
+    inline static unsigned long long mDiscoveryPassCount = 0;      //!< Number of discovery passes run by the filter of the main window
 };
 
 /**
@@ -118,8 +141,8 @@ private:
  * @class RelationOpenGLWidgetFilter
  * @brief Custom event filter for the QOpenGLWidget within the Relation View
  * @details Implemented as a singleton. This filter handles mouse events for panning and zooming the view within the QOpenGLWidget.
- * @note Relation OpenGLWidget view seems not be opened in multiple navigator windows at the same time,
- *       that is, we can assume only one navigator window is open at a time.
+ * @note A floating Navigator and a docked Filtered Navigator can show relation views at the same time,
+ *       so the drag state is kept for each QOpenGLWidget.
  * @note QObject::installEventFilter(QObject * filterObj) will not install the same filterObj multiple times on the same QObject,
  *       that's why we use a singleton here.
  */
@@ -149,6 +172,20 @@ public:
         return instance;
     }
 
+    /**
+     * @brief Start tracking the state of the relation view
+     * @details Removes the drag state and the view state of the relation view when the widget is destroyed.
+     * @param widget The QOpenGLWidget which shows the relation view
+     * @note This can be called repeatedly for the same widget.
+     */
+    void trackRelationView(QOpenGLWidget *widget);
+
+    /**
+     * @brief Stop tracking the states of all relation views
+     * @note This is called when the application is exiting, before RelationDialogManager is destroyed.
+     */
+    void untrackRelationViews();
+
 protected:
     /**
      * @brief Event filter method
@@ -190,7 +227,17 @@ private:
         Scale
     };
 
-    DragMode mCurrentDragMode; //!< Temporary state for mouse drag mode
-    bool mIsDragging = false;  //!< Temporary state for mouse dragging
-    QPoint mDragStartPosition; //!< Temporary state for mouse drag start position
+    /**
+     * @struct DragState
+     * @brief Temporary state of the mouse drag in a relation view
+     */
+    struct DragState
+    {
+        DragMode mCurrentDragMode = DragMode::Translate; //!< Temporary state for mouse drag mode
+        bool mIsDragging = false;                        //!< Temporary state for mouse dragging
+        QPoint mDragStartPosition;                       //!< Temporary state for mouse drag start position
+    };
+
+    /// Map to store the drag state for each relation view, so drags in one view do not affect the others
+    std::unordered_map<const QOpenGLWidget *, DragState> mDragStates;
 };
@@ -1,13 +1,18 @@
 #include "SearchDialog.h"
 
+#include <algorithm>
+
+#include <QtCore/QDeadlineTimer>
+#include <QtCore/QPointer>
 #include <QtCore/QRect>
+#include <QtCore/QSignalBlocker>
 #include <QtCore/QStringList>
 #include <QtCore/QtConfig>
-#include <QtCore/QTimer>
 #include <QtCore/QUrl>
 #include <QtCore/QUrlQuery>
 #include <QtGui/QPainter>
 #include <QtGui/QDesktopServices>
+#include <QtWidgets/QApplication>
 #include <QtWidgets/QMenu>
 
 #if QT_VERSION_MAJOR >= 6
@@ -17,7 +22,9 @@
 #endif
 
 #include "SearchBoxLineEdit.h"
+#include "CustomEventFilters.h"
 #include "PreferencesDialog.h"
+#include "RelationDialogManager.h"
 #include "SuggestionProvider.h"
 #include "Utility.h"
 
@@ -26,9 +33,43 @@ const QString MOBU_HELP_LANGUAGE = "ENU";
 const QString HELP_RELATIONS_REFERENCE_GUID = "GUID-C50152F9-5607-4779-A964-186B4E1A0601";
 const QString GITHUB_REPOSITORY_URL = "https://github.com/Ndgt/Relation-Constraint-Dialog";
 
-SearchDialog::SearchDialog(const QPoint &cursorPosition, const QPoint &relationPosition, FBConstraintRelation *selectedConstraint)
-    : QDialog(nullptr), ui(new Ui::Dialog), mCursorPosition(cursorPosition), mRelationPosition(relationPosition), mSelectedConstraint(selectedConstraint)
+SearchDialog *SearchDialog::getInstance()
+{
+    static QPointer<SearchDialog> instance;
+
+    if (!instance)
+    {
+        QElapsedTimer setupTimer;
+        setupTimer.start();
+
+        instance = new SearchDialog();
+
+        // Apply the style sheet and create the native window in advance
+        instance->ensurePolished();
+        instance->create();
+
+        // Time the construction only, which is paid once now that the dialog is reused
+        instance->mSetupTimeMs = setupTimer.nsecsElapsed() / 1.0e6;
+
+        // The dialog has no parent, so delete it explicitly
+        connect(qApp, &QCoreApplication::aboutToQuit, instance, &QObject::deleteLater);
+    }
+
+    return instance;
+}
+
+void SearchDialog::startOpenLatencyTimer()
 {
+    mOpenLatencyTimer.start();
+}
+
+bool SearchDialog::openAt(const QPoint &cursorPosition, const QPoint &relationPosition, FBConstraintRelation *selectedConstraint)
+{
+    // Measure from here if the caller did not start the timer on the key press
+    if (!mOpenLatencyTimer.isValid())
+        mOpenLatencyTimer.start();
+
+    mSelectedConstraint = selectedConstraint;
     if (!mSelectedConstraint.Ok())
     {
         // Display warning if the constraint is not valid
@@ -36,17 +77,42 @@ SearchDialog::SearchDialog(const QPoint &cursorPosition, const QPoint &relationP
                      "[Error] No Relation Constraint is selected.\nMake sure the relation is selected in the scene browser.",
                      "OK");
 
-        // close dialog
-        QTimer::singleShot(0, this, SLOT(close()));
+        return false;
     }
 
+    mCursorPosition = cursorPosition;
+    mRelationPosition = relationPosition;
+
+    // Reset the query and the find option without refreshing the suggestion list for each change
+    // Note: The suggestion list is populated once in showEvent
+    {
+        const QSignalBlocker lineEditBlocker(ui->lineEdit);
+        const QSignalBlocker buttonGroupBlocker(ui->buttonGroup);
+        ui->lineEdit->clear();
+        ui->radioButtonOperator->setChecked(true);
+    }
+
+    // Use the suggestion data warmed up on the relation selection, discarding it if the scene has changed since
+    SuggestionProvider::getInstance().prepareForInvocation(mSelectedConstraint);
+
+    mIsFirstPaintPending = true;
+    show();
+    activateWindow();
+    ui->lineEdit->setFocus();
+
+    return true;
+}
+
+SearchDialog::SearchDialog(QWidget *parent)
+    : QDialog(parent), ui(new Ui::Dialog)
+{
     // Populate UI elements from ui_SearchDialog.h - generated from .ui file
     ui->setupUi(this);
 
     Qt::WindowFlags flags;
 
-    // Set the dialog style to be a popup and delete automatically on close
-    setAttribute(Qt::WA_DeleteOnClose);
+    // Set the dialog style to be a popup
+    // Note: The dialog is reused, so it is only hidden on close
     flags |= Qt::Popup;
 
     // Set addtinal attributes and styles so that the overridden paintEvent will work
@@ -73,9 +139,6 @@ SearchDialog::SearchDialog(const QPoint &cursorPosition, const QPoint &relationP
 #else
     connect(ui->buttonGroup, QOverload<QAbstractButton *, bool>::of(&QButtonGroup::buttonToggled), this, &SearchDialog::onRadioButtonGroupToggled);
 #endif
-
-    // Let the SuggestionProvider collect current scene model long names for suggestions
-    SuggestionProvider::getInstance().initializeModelSuggestions();
 }
 
 void SearchDialog::initializeActions()
@@ -85,6 +148,9 @@ void SearchDialog::initializeActions()
     mSettingsActionPreferences = new QAction("Preferences...", this);
     settingsActionGroup->addAction(mSettingsActionPreferences);
 
+    mSettingsActionPerformanceReport = new QAction("Performance Report", this);
+    settingsActionGroup->addAction(mSettingsActionPerformanceReport);
+
     mSettingsActionHelpReference = new QAction("Relations Reference", this);
     settingsActionGroup->addAction(mSettingsActionHelpReference);
 
@@ -101,6 +167,39 @@ void SearchDialog::paintEvent(QPaintEvent *event)
     painter.setPen(Qt::NoPen);
     painter.setBrush(palette().window());
     painter.drawRoundedRect(rect(), ui->frame->property("BorderRadius").toUInt(), ui->frame->property("BorderRadius").toUInt());
+
+    // Measure the latency from the Tab key press to the first paint
+    if (mIsFirstPaintPending)
+    {
+        mIsFirstPaintPending = false;
+
+        double latencyMs = mOpenLatencyTimer.nsecsElapsed() / 1.0e6;
+        mOpenLatencyTimer.invalidate();
+
+        mMinOpenLatencyMs = mOpenCount == 0 ? latencyMs : std::min(mMinOpenLatencyMs, latencyMs);
+        mMaxOpenLatencyMs = std::max(mMaxOpenLatencyMs, latencyMs);
+        mTotalOpenLatencyMs += latencyMs;
+        mOpenCount++;
+    }
+}
+
+void SearchDialog::traceOpenLatencyReport() const
+{
+    DIALOG_DEBUG_START;
+
+    if (mOpenCount == 0)
+        DIALOG_DEBUG_MESSAGE("SearchDialog has not been opened yet.");
+    else
+    {
+        DIALOG_DEBUG_MESSAGE("Tab-to-first-paint: average %.2f ms, min %.2f ms, max %.2f ms over %llu opens",
+                             mTotalOpenLatencyMs / mOpenCount, mMinOpenLatencyMs, mMaxOpenLatencyMs, mOpenCount);
+    }
+
+    // Note: Only the construction is timed at prewarm. The latency of opening a newly created dialog is not measured,
+    //       so this is not a before/after comparison of the open latency
+    DIALOG_DEBUG_MESSAGE("Dialog setup time at prewarm (construction only, excluding show and first paint): %.2f ms", mSetupTimeMs);
+
+    DIALOG_DEBUG_END_NOTFAILURE;
 }
 
 void SearchDialog::showEvent(QShowEvent *event)
@@ -112,8 +211,10 @@ void SearchDialog::showEvent(QShowEvent *event)
     QPoint openPosition = mCursorPosition - QPoint(0, ui->lineEdit->geometry().y());
     move(openPosition);
 
-    // Populate list with operator suggestions
-    QStringList allSuggestions = SuggestionProvider::getInstance().getOperatorSuggestions(QString());
+    // Populate list with operator suggestions, replacing the items of the previous invocation
+    QStringList allSuggestions = SuggestionProvider::getInstance().getOperatorSuggestions(QString(), mSelectedConstraint);
+    cancelModelSuggestionStream();
+    ui->listWidget->clear();
     ui->listWidget->addItems(allSuggestions);
 
     // Set the topmost item as the current item
@@ -123,6 +224,10 @@ void SearchDialog::showEvent(QShowEvent *event)
 
 void SearchDialog::finalize()
 {
+    // Nothing to select while the models are being collected
+    if (ui->radioButtonModel->isChecked() && !SuggestionProvider::getInstance().isModelCollectionCompleted())
+        return;
+
     QListWidgetItem *item = ui->listWidget->currentItem();
 
     if (!item && ui->listWidget->count() > 0)
@@ -184,9 +289,25 @@ void SearchDialog::finalize()
     // Model
     else
     {
-        // Get Scene model with selected item name
-        QByteArray selectedItemBytes = selectedItemText.toUtf8();
-        FBModel *selectedItemModel = FBFindModelByLabelName(selectedItemBytes.constData());
+        // Get Scene model from the entry of the selected item
+        SuggestionProvider &provider = SuggestionProvider::getInstance();
+        FBModel *selectedItemModel = nullptr;
+
+        if (provider.isModelCollectionCompleted() && provider.getModelSuggestionsRevision() == mModelSuggestionStreamRevision)
+            selectedItemModel = provider.getSuggestedModel(item->data(Qt::UserRole).toInt(), mModelSuggestionStreamRevision);
+        else
+        {
+            // The models are collected again since the list was filled, so resolve the item in the current collection
+            selectedItemModel = provider.getSuggestedModelByLongName(selectedItemText);
+
+            // The item is outdated, so show the current suggestions instead of picking another model
+            if (!selectedItemModel)
+            {
+                onTextChanged(ui->lineEdit->text());
+                return;
+            }
+        }
+
         if (!selectedItemModel)
         {
             QString errorStr = "[Error] Model \"" + selectedItemText + "\" is not found in the scene.";
@@ -199,14 +320,15 @@ void SearchDialog::finalize()
         else
         {
             // Configure custom menu for relation object type selection
-            QMenu *menu = new QMenu(this);
-            QAction *action1 = menu->addAction("Set as Source Object");
-            QAction *action2 = menu->addAction("Constrain Object");
-            menu->setActiveAction(action1); // default selection
+            // Note: The dialog is reused, so do not leave the menu as its child
+            QMenu menu(this);
+            QAction *action1 = menu.addAction("Set as Source Object");
+            QAction *action2 = menu.addAction("Constrain Object");
+            menu.setActiveAction(action1); // default selection
 
             // Show menu next to the current item
             QRect itemRect = ui->listWidget->visualItemRect(item);
-            QAction *action = menu->exec(ui->listWidget->mapToGlobal(QPoint(itemRect.x() + itemRect.width(), itemRect.y())));
+            QAction *action = menu.exec(ui->listWidget->mapToGlobal(QPoint(itemRect.x() + itemRect.width(), itemRect.y())));
 
             if (action && mSelectedConstraint.Ok())
             {
@@ -279,23 +401,104 @@ void SearchDialog::onRadioButtonGroupToggled(QAbstractButton *button, bool check
 
 void SearchDialog::onTextChanged(const QString &text)
 {
+    cancelModelSuggestionStream();
     ui->listWidget->clear();
 
-    QStringList allSuggestions;
-
     // Get suggestion name list
     if (ui->radioButtonOperator->isChecked())
-        allSuggestions = SuggestionProvider::getInstance().getOperatorSuggestions(text);
+        ui->listWidget->addItems(SuggestionProvider::getInstance().getOperatorSuggestions(text, mSelectedConstraint));
+    else if (SuggestionProvider::getInstance().isModelCollectionCompleted())
+        startModelSuggestionStream(text);
     else
-        allSuggestions = SuggestionProvider::getInstance().getModelSuggestions(text);
-
-    ui->listWidget->addItems(allSuggestions);
+    {
+        // Show the loading state, and refresh the list with the current text when the models are collected
+        QListWidgetItem *loadingItem = new QListWidgetItem("Loading models...", ui->listWidget);
+        loadingItem->setFlags(Qt::NoItemFlags);
+
+        SuggestionProvider::getInstance().requestModelSuggestions(this, [this]()
+                                                                  {
+                                                                      if (isVisible() && ui->radioButtonModel->isChecked())
+                                                                          onTextChanged(ui->lineEdit->text()); });
+        return;
+    }
 
     // Set current row on the top of list
     if (ui->listWidget->count() > 0)
         ui->listWidget->setCurrentRow(0);
 }
 
+void SearchDialog::startModelSuggestionStream(const QString &text)
+{
+    SuggestionProvider &provider = SuggestionProvider::getInstance();
+
+    mModelSuggestionStreamQuery = provider.compileModelQuery(text);
+    mModelSuggestionStreamState = {};
+    mModelSuggestionStreamRevision = provider.getModelSuggestionsRevision();
+
+    // Show the first screenful right away, so the dialog is interactive in a bounded time regardless of the scene size
+    const int firstPageCount = ui->listWidget->viewport()->height() / suggestionRowMinimumHeight + 1;
+
+    QList<SuggestionProvider::ModelSuggestion> suggestions;
+    const bool isCompleted = provider.getModelSuggestionBatch(mModelSuggestionStreamQuery, mModelSuggestionStreamState, firstPageCount,
+                                                              QDeadlineTimer(firstPageBudgetMs), suggestions);
+    addModelSuggestionItems(suggestions);
+
+    if (isCompleted)
+        return;
+
+    // Stream the remainder in batches, the scroll bar grows as they arrive
+    mModelSuggestionStreamJobId = TaskScheduler::getInstance().schedule(
+        [this](const QDeadlineTimer &deadline)
+        { return streamModelSuggestions(deadline); },
+        TaskScheduler::Priority::High,
+        [this]()
+        { mModelSuggestionStreamJobId = 0; });
+}
+
+bool SearchDialog::streamModelSuggestions(const QDeadlineTimer &deadline)
+{
+    if (!isVisible())
+        return false;
+
+    SuggestionProvider &provider = SuggestionProvider::getInstance();
+
+    // The models have been collected again since the stream was started, so start over with the current text
+    if (!provider.isModelCollectionCompleted() || provider.getModelSuggestionsRevision() != mModelSuggestionStreamRevision)
+    {
+        onTextChanged(ui->lineEdit->text());
+        return false;
+    }
+
+    QList<SuggestionProvider::ModelSuggestion> suggestions;
+    const bool isCompleted = provider.getModelSuggestionBatch(mModelSuggestionStreamQuery, mModelSuggestionStreamState,
+                                                              modelSuggestionBatchCount, deadline, suggestions);
+
+    const bool wasEmpty = ui->listWidget->count() == 0;
+    addModelSuggestionItems(suggestions);
+
+    // The first page had no matches, so select the first item which has arrived
+    if (wasEmpty && ui->listWidget->count() > 0)
+        ui->listWidget->setCurrentRow(0);
+
+    return !isCompleted;
+}
+
+void SearchDialog::addModelSuggestionItems(const QList<SuggestionProvider::ModelSuggestion> &suggestions)
+{
+    for (const auto &suggestion : suggestions)
+    {
+        // Keep the entry index, so the picked model is resolved without searching the scene
+        QListWidgetItem *item = new QListWidgetItem(suggestion.longName, ui->listWidget);
+        item->setData(Qt::UserRole, suggestion.entryIndex);
+    }
+}
+
+void SearchDialog::cancelModelSuggestionStream()
+{
+    TaskScheduler::getInstance().cancel(mModelSuggestionStreamJobId);
+    mModelSuggestionStreamJobId = 0;
+}
+
 void SearchDialog::onSettingsButtonClicked(bool checked)
 {
     Q_UNUSED(checked);
@@ -303,6 +506,7 @@ void SearchDialog::onSettingsButtonClicked(bool checked)
     QMenu menu = QMenu(this);
 
     menu.addAction(mSettingsActionPreferences);
+    menu.addAction(mSettingsActionPerformanceReport);
     QMenu *onlineHelpMenu = menu.addMenu("Online Help");
     onlineHelpMenu->addAction(mSettingsActionHelpReference);
     onlineHelpMenu->addAction(mSettingsActionHelpGitHub);
@@ -326,6 +530,16 @@ void SearchDialog::onSettingsActionTriggered(QAction *action)
         PreferencesDialog *preferencesDialog = new PreferencesDialog(mainWindow);
         preferencesDialog->show();
     }
+    else if (action == mSettingsActionPerformanceReport)
+    {
+        // Output the render cost of the relation views, the latency of the dialog, the suggestion warm-up hits
+        // and the navigator discovery passes recorded so far, and time the relation constraint lookup by name in the current scene
+        RelationDialogManager::getInstance().traceRelationRenderCostReport();
+        traceOpenLatencyReport();
+        SuggestionProvider::getInstance().traceSuggestionReport();
+        MainWindowFilter::traceNavigatorDiscoveryReport();
+        traceConstraintRelationLookupReport();
+    }
     else
     {
         QUrl helpUrl;
@@ -2,6 +2,9 @@
 
 #include "ui_SearchDialog.h"
 
+#include <QtCore/QDeadlineTimer>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QList>
 #include <QtCore/QPoint>
 #include <QtCore/QString>
 #include <QtGui/QPaintEvent>
@@ -18,9 +21,13 @@
 
 #include <fbsdk/fbsdk.h>
 
+#include "SuggestionProvider.h"
+#include "TaskScheduler.h"
+
 /**
  * @class SearchDialog
  * @brief Dialog for searching and selecting FBConstraintRelation objects
+ * @details One instance is created per session and reused on each Tab key press, so the UI setup cost is paid only once.
  */
 class SearchDialog : public QDialog
 {
@@ -28,13 +35,32 @@ class SearchDialog : public QDialog
 
 public:
     /**
-     * @brief Constructor
-     * @details Sets up the UI elements and connects the necessary signals and slots.
+     * @brief Get the session-wide instance of the SearchDialog, creating it if necessary
+     * @return Pointer to the instance, deleted when the application is about to quit
+     * @note Call this once in advance to prewarm the dialog, so that the first Tab key press does not pay the setup cost.
+     */
+    static SearchDialog *getInstance();
+
+    /**
+     * @brief Reset the dialog and open it for the relation constraint
+     * @details Clears the query, resets the find option to operators and shows the dialog at the cursor position.
      * @param cursorPosition The cursor position where the dialog should appear
      * @param relationPosition The position where the new relation object should be created
      * @param selectedConstraint The currently selected FBConstraintRelation object
+     * @return true if the dialog is opened, false if selectedConstraint is not valid
+     */
+    bool openAt(const QPoint &cursorPosition, const QPoint &relationPosition, FBConstraintRelation *selectedConstraint);
+
+    /**
+     * @brief Start measuring the latency from the Tab key press to the first paint of the dialog
+     * @note This is called by the event filters when they handle the Tab key press, before openAt.
+     */
+    void startOpenLatencyTimer();
+
+    /**
+     * @brief Output the latency from the Tab key press to the first paint, and the construction time of the dialog at prewarm
      */
-    explicit SearchDialog(const QPoint &cursorPosition, const QPoint &relationPosition, FBConstraintRelation *selectedConstraint);
+    void traceOpenLatencyReport() const;
 
     /**
      * @brief Destructor
@@ -56,6 +82,15 @@ protected:
      */
     void showEvent(QShowEvent *event) override;
 
+private:
+    /**
+     * @brief Constructor
+     * @details Sets up the UI elements and connects the necessary signals and slots.
+     * @param parent The parent widget, default is nullptr
+     * @note Use getInstance() to get the session-wide instance.
+     */
+    explicit SearchDialog(QWidget *parent = nullptr);
+
 private slots:
     /**
      * @brief Finalize the dialog selection and create relation objects
@@ -115,7 +150,8 @@ private slots:
     /**
      * @brief Handle settings action triggered event
      * @details This slot executes the corresponding action based on the triggered action,
-     *          such as opening the config file or help pages in the default web browser.
+     *          such as opening the config file, outputting the render cost report or opening help pages
+     *          in the default web browser.
      * @param action The triggered action
      */
     void onSettingsActionTriggered(QAction *action);
@@ -126,13 +162,55 @@ private:
      */
     void initializeActions();
 
+    /**
+     * @brief Show the first screenful of model suggestions and stream the remainder in batches
+     * @param text The query text
+     */
+    void startModelSuggestionStream(const QString &text);
+
+    /**
+     * @brief Append the next batches of model suggestions to the list until the deadline expires
+     * @param deadline The deadline of the current TaskScheduler slice
+     * @return true if more suggestions remain, false if the stream is completed or stopped
+     */
+    bool streamModelSuggestions(const QDeadlineTimer &deadline);
+
+    /**
+     * @brief Append model suggestions to the list, keeping their entry indices as the item data
+     * @param suggestions The model suggestions to append
+     */
+    void addModelSuggestionItems(const QList<SuggestionProvider::ModelSuggestion> &suggestions);
+
+    /**
+     * @brief Cancel the model suggestion stream in progress, if any
+     */
+    void cancelModelSuggestionStream();
+
 private:
+    static constexpr int suggestionRowMinimumHeight = 18; //!< Minimum height of a suggestion row, as in the style sheet of the list
+    static constexpr int firstPageBudgetMs = 8;           //!< Time budget in milliseconds to find the first screenful of model suggestions
+    static constexpr int modelSuggestionBatchCount = 256; //!< Maximum number of model suggestions appended in one batch
+
     Ui::Dialog *ui;                                              //!< Pointer to the Widget Container class generated from the .ui file
     QPoint mCursorPosition;                                      //!< The cursor position where the dialog should appear
     QPoint mRelationPosition;                                    //!< The position where the new relation object should be created
     HdlFBPlugTemplate<FBConstraintRelation> mSelectedConstraint; //!< The handle to the currently selected constraint object
 
-    QAction *mSettingsActionPreferences;   //!< Action to open the preferences dialog
-    QAction *mSettingsActionHelpReference; //!< Action to open the reference help page
-    QAction *mSettingsActionHelpGitHub;    //!< Action to open the GitHub repository page
+    QElapsedTimer mOpenLatencyTimer;   //!< Timer started on the Tab key press, to measure the latency to the first paint
+    bool mIsFirstPaintPending = false; //!< Flag indicating that the first paint after openAt has not happened yet
+    unsigned long long mOpenCount = 0; //!< Number of measured opens
+    double mTotalOpenLatencyMs = 0.0;  //!< Sum of the measured latencies in milliseconds
+    double mMinOpenLatencyMs = 0.0;    //!< Minimum measured latency in milliseconds
+    double mMaxOpenLatencyMs = 0.0;    //!< Maximum measured latency in milliseconds
+    double mSetupTimeMs = 0.0;         //!< Time to create and prewarm the dialog in milliseconds
+
+    TaskScheduler::JobId mModelSuggestionStreamJobId = 0;                  //!< Identifier of the job streaming the model suggestions, 0 if none
+    ModelQuery mModelSuggestionStreamQuery;                                //!< Compiled query of the model suggestion stream
+    SuggestionProvider::ModelSuggestionStream mModelSuggestionStreamState; //!< State to resume the model suggestion stream from
+    unsigned int mModelSuggestionStreamRevision = 0;                       //!< Revision of the model suggestions the stream state and item data refer to
+
+    QAction *mSettingsActionPreferences;       //!< Action to open the preferences dialog
+    QAction *mSettingsActionPerformanceReport; //!< Action to output the performance report of the relation views, the dialog, the suggestions and the relation lookup
+    QAction *mSettingsActionHelpReference;     //!< Action to open the reference help page
+    QAction *mSettingsActionHelpGitHub;        //!< Action to open the GitHub repository page
 };
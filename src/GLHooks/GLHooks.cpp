@@ -1,6 +1,9 @@
 #include "GLHooks.h"
 
+#include <algorithm>
 #include <atomic>
+#include <chrono>
+#include <cmath>
 #include <mutex>
 #include <unordered_map>
 #include <vector>
@@ -17,6 +20,13 @@
  */
 typedef void(WINAPI *GLBINDFRAMEBUFFERTRUE)(GLenum target, GLuint framebuffer);
 
+/**
+ * @typedef GLDELETEFRAMEBUFFERSTRUE
+ * @brief Function pointer type for glDeleteFramebuffers
+ * @note The function glDeleteFramebuffers is avalilable since OpenGL 3.0, cannot use from gl/GL.h.
+ */
+typedef void(WINAPI *GLDELETEFRAMEBUFFERSTRUE)(GLsizei n, const GLuint *framebuffers);
+
 /**
  * @typedef GLBEGINTRUE
  * @brief Function pointer type for glBegin
@@ -41,25 +51,280 @@ typedef void(WINAPI *GLRECTFTRUE)(GLfloat x1, GLfloat y1, GLfloat x2, GLfloat y2
  */
 typedef void(WINAPI *GLVERTEX2DTRUE)(GLdouble x, GLdouble y);
 
+/**
+ * @struct RelationViewTransform
+ * @brief The OpenGL transform state captured while the relation view is being rendered
+ * @note The matrices are stored in column-major order, as returned by glGetDoublev.
+ */
+struct RelationViewTransform
+{
+    std::array<GLdouble, 16> modelview;  //!< GL_MODELVIEW_MATRIX at the time of capture
+    std::array<GLdouble, 16> projection; //!< GL_PROJECTION_MATRIX at the time of capture
+    std::array<GLint, 4> viewport;       //!< GL_VIEWPORT at the time of capture
+};
+
+/**
+ * @enum FramebufferClass
+ * @brief Classification of a framebuffer, cached per framebuffer ID
+ */
+enum class FramebufferClass
+{
+    Unknown,      //!< Not classified yet, probed for the grid line signature of the relation view
+    RelationView, //!< Used by a relation view
+    Other         //!< Used by other views (3D viewer, other panes, etc.)
+};
+
+/**
+ * @struct FramebufferClassification
+ * @brief Cached classification state of a framebuffer
+ */
+struct FramebufferClassification
+{
+    FramebufferClass type = FramebufferClass::Unknown; //!< The current classification
+    int probeCount = 0;                                //!< Number of binds probed while the type is Unknown
+};
+
+/**
+ * @brief Number of binds an unknown framebuffer is probed for the grid line signature before it is classified as Other
+ */
+constexpr int maxFramebufferProbeCount = 8;
+
 static GLBINDFRAMEBUFFERTRUE glBindFramebufferTrue = (GLBINDFRAMEBUFFERTRUE)wglGetProcAddress("glBindFramebuffer");
+static GLDELETEFRAMEBUFFERSTRUE glDeleteFramebuffersTrue = (GLDELETEFRAMEBUFFERSTRUE)wglGetProcAddress("glDeleteFramebuffers");
 static GLBEGINTRUE glBeginTrue = glBegin;
 static GLENDTRUE glEndTrue = glEnd;
 static GLRECTFTRUE glRectfTrue = glRectf;
 static GLVERTEX2DTRUE glVertex2dTrue = glVertex2d;
 
 static std::mutex gBoxRangeArrayMutex;         //!< Mutex to protect access to gBoxRectRange
-static std::recursive_mutex gFramebufferMutex; //!< Mutex to protect access to gCurrentRelationViewFramebuffer
+static std::recursive_mutex gFramebufferMutex; //!< Mutex to protect access to gCurrentRelationViewFramebuffer and gFramebufferClasses
 static std::mutex gGridLineMutex;              //!< Mutex to protect access to gGridLineXCoords and gLastGridSpacing
+static std::mutex gTransformMutex;             //!< Mutex to protect access to gRelationViewTransforms
 
 static std::atomic<bool> gIsCapturingGridLines = false;         //!< Flag to indicate if we are currently capturing grid line coordinates
 static std::atomic<bool> gIsDataResetRequired = false;          //!< Flag to indicate if internal data reset is required
+static std::atomic<bool> gIsRelationViewRendering = false;      //!< Flag to indicate if the bound framebuffer is (or may be) used by a relation view
 static std::atomic<bool> gIsSpacingCalculationRequired = false; //!< Flag to indicate if spacing calculation is required
+static std::atomic<bool> gIsRelationViewFrameActive = false;    //!< Flag to indicate if a relation view framebuffer is bound and its draw calls are being counted
+
+static std::atomic<unsigned int> gFrameRectCount = 0;     //!< Number of glRectf calls in the current relation view frame
+static std::atomic<unsigned int> gFrameVertexCount = 0;   //!< Number of glVertex2d calls in the current relation view frame
+static std::atomic<unsigned int> gFrameBeginEndCount = 0; //!< Number of glBegin/glEnd pairs in the current relation view frame
+
+static std::chrono::steady_clock::time_point gFrameStartTime; //!< The time the current relation view frame started, protected by gFramebufferMutex
+static RelationViewFrameStatsListener gFrameStatsListener;    //!< The listener notified of completed relation view frames, protected by gFramebufferMutex
+
+/**
+ * @struct PendingFrameCallback
+ * @brief One-shot callback waiting for the next completed relation view frame
+ */
+struct PendingFrameCallback
+{
+    RelationViewFrameCallbackId id;     //!< Identifier to cancel the callback with
+    GLint framebuffer;                  //!< Framebuffer to wait for, or -1 for any relation view
+    RelationViewFrameCallback callback; //!< Function to call once
+};
+
+/// One-shot callbacks waiting for the next completed relation view frame, protected by gFramebufferMutex
+static std::vector<PendingFrameCallback> gPendingFrameCallbacks;
+static RelationViewFrameCallbackId gLastFrameCallbackId = 0; //!< The last identifier given to a pending callback, protected by gFramebufferMutex
 
 static std::unordered_map<GLint, std::array<double, 4>> gBoxRectRange;  //!< Array to store the bounding rectangle of rendered boxes in the relation view
-static GLint gCurrentRelationViewFramebuffer;                           //!< The framebuffer used by the relation view
+static GLint gCurrentRelationViewFramebuffer;                           //!< The framebuffer currently bound
 static std::unordered_map<GLint, std::vector<double>> gGridLineXCoords; //!< Vector to store captured x-coordinates of grid lines
 static std::unordered_map<GLint, double> gLastGridSpacing;              //!< The last calculated grid spacing
 
+/// The transform state captured during the last rendering of each relation view framebuffer
+static std::unordered_map<GLint, RelationViewTransform> gRelationViewTransforms;
+
+/// The cached classification of each framebuffer bound so far
+static std::unordered_map<GLint, FramebufferClassification> gFramebufferClasses;
+
+/**
+ * @brief Remove all captured data of the framebuffer
+ * @param framebuffer The framebuffer whose data should be removed
+ * @note gFramebufferMutex must be locked by the caller.
+ */
+static void eraseFramebufferData(GLint framebuffer)
+{
+    {
+        std::lock_guard<std::mutex> lock(gGridLineMutex);
+        gGridLineXCoords.erase(framebuffer);
+        gLastGridSpacing.erase(framebuffer);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(gBoxRangeArrayMutex);
+        gBoxRectRange.erase(framebuffer);
+    }
+
+    {
+        std::lock_guard<std::mutex> lock(gTransformMutex);
+        gRelationViewTransforms.erase(framebuffer);
+    }
+}
+
+/**
+ * @brief Look up the classification of the framebuffer being bound
+ * @details Unknown framebuffers are probed a limited number of times, and classified as Other
+ *          if the grid line signature of the relation view has not been detected.
+ * @param framebuffer The framebuffer being bound
+ * @return The classification of the framebuffer
+ * @note gFramebufferMutex must be locked by the caller.
+ */
+static FramebufferClass classifyBoundFramebuffer(GLint framebuffer)
+{
+    FramebufferClassification &classification = gFramebufferClasses[framebuffer];
+
+    if (classification.type == FramebufferClass::Unknown && ++classification.probeCount > maxFramebufferProbeCount)
+    {
+        classification.type = FramebufferClass::Other;
+
+        // Data captured while probing is no longer needed
+        eraseFramebufferData(framebuffer);
+    }
+
+    return classification.type;
+}
+
+/**
+ * @brief Check the captured grid line coordinates for the signature of the relation view
+ * @details The relation view draws its vertical grid lines with a single GL_LINES batch of glVertex2d calls
+ *          starting from the smallest x-coordinate, so the captured x-coordinates come in equal pairs
+ *          which increase from line to line.
+ * @param xCoords The captured x-coordinates, at least five elements
+ * @return true if the coordinates match the signature, false otherwise
+ */
+static bool matchesGridLineSignature(const std::vector<double> &xCoords)
+{
+    return xCoords[0] == xCoords[1] && xCoords[2] == xCoords[3] && xCoords[2] > xCoords[1] && xCoords[4] > xCoords[3];
+}
+
+void setRelationViewFrameStatsListener(RelationViewFrameStatsListener listener)
+{
+    std::lock_guard<std::recursive_mutex> lock(gFramebufferMutex);
+    gFrameStatsListener = std::move(listener);
+}
+
+RelationViewFrameCallbackId requestNextRelationViewFrameCallback(GLint framebuffer, RelationViewFrameCallback callback)
+{
+    if (!callback)
+        return 0;
+
+    std::lock_guard<std::recursive_mutex> lock(gFramebufferMutex);
+    const RelationViewFrameCallbackId callbackId = ++gLastFrameCallbackId;
+    gPendingFrameCallbacks.push_back(PendingFrameCallback{callbackId, framebuffer, std::move(callback)});
+    return callbackId;
+}
+
+void cancelRelationViewFrameCallback(RelationViewFrameCallbackId callbackId)
+{
+    if (callbackId == 0)
+        return;
+
+    std::lock_guard<std::recursive_mutex> lock(gFramebufferMutex);
+    gPendingFrameCallbacks.erase(std::remove_if(gPendingFrameCallbacks.begin(), gPendingFrameCallbacks.end(),
+                                                [callbackId](const PendingFrameCallback &pending)
+                                                { return pending.id == callbackId; }),
+                                 gPendingFrameCallbacks.end());
+}
+
+void registerRelationViewFramebuffer(GLint framebuffer)
+{
+    if (framebuffer <= 0)
+        return;
+
+    std::lock_guard<std::recursive_mutex> lock(gFramebufferMutex);
+    gFramebufferClasses[framebuffer].type = FramebufferClass::RelationView;
+}
+
+/**
+ * @brief Multiply two 4x4 matrices stored in column-major order
+ * @param a The left-hand side matrix
+ * @param b The right-hand side matrix
+ * @return The product a * b in column-major order
+ */
+static std::array<GLdouble, 16> multiplyMatrix4(const std::array<GLdouble, 16> &a, const std::array<GLdouble, 16> &b)
+{
+    std::array<GLdouble, 16> product;
+
+    for (int col = 0; col < 4; ++col)
+    {
+        for (int row = 0; row < 4; ++row)
+        {
+            GLdouble sum = 0.0;
+            for (int k = 0; k < 4; ++k)
+                sum += a[k * 4 + row] * b[col * 4 + k];
+
+            product[col * 4 + row] = sum;
+        }
+    }
+
+    return product;
+}
+
+/**
+ * @brief Invert a 4x4 matrix stored in column-major order
+ * @details Uses Gauss-Jordan elimination with partial pivoting.
+ * @param m The matrix to invert
+ * @param outInverse Output parameter to receive the inverse matrix in column-major order
+ * @return true if the matrix is invertible, false otherwise
+ */
+static bool invertMatrix4(const std::array<GLdouble, 16> &m, std::array<GLdouble, 16> &outInverse)
+{
+    // Augmented matrix [m | I] in row-major order
+    GLdouble augmented[4][8];
+    for (int row = 0; row < 4; ++row)
+    {
+        for (int col = 0; col < 4; ++col)
+        {
+            augmented[row][col] = m[col * 4 + row];
+            augmented[row][col + 4] = (row == col) ? 1.0 : 0.0;
+        }
+    }
+
+    for (int col = 0; col < 4; ++col)
+    {
+        // Choose the row with the largest absolute value in this column as the pivot
+        int pivotRow = col;
+        for (int row = col + 1; row < 4; ++row)
+        {
+            if (std::abs(augmented[row][col]) > std::abs(augmented[pivotRow][col]))
+                pivotRow = row;
+        }
+
+        if (augmented[pivotRow][col] == 0.0)
+            return false; // Singular matrix
+
+        if (pivotRow != col)
+            std::swap(augmented[pivotRow], augmented[col]);
+
+        // Normalize the pivot row
+        const GLdouble pivotInv = 1.0 / augmented[col][col];
+        for (int k = 0; k < 8; ++k)
+            augmented[col][k] *= pivotInv;
+
+        // Eliminate the column from the other rows
+        for (int row = 0; row < 4; ++row)
+        {
+            const GLdouble factor = augmented[row][col];
+            if (row == col || factor == 0.0)
+                continue;
+
+            for (int k = 0; k < 8; ++k)
+                augmented[row][k] -= factor * augmented[col][k];
+        }
+    }
+
+    for (int row = 0; row < 4; ++row)
+    {
+        for (int col = 0; col < 4; ++col)
+            outInverse[col * 4 + row] = augmented[row][col + 4];
+    }
+
+    return true;
+}
+
 double getLastGridSpacing(GLint framebuffer)
 {
     std::lock_guard<std::mutex> lock(gGridLineMutex);
@@ -80,6 +345,51 @@ std::array<double, 4> getBoxRectRange(GLint framebuffer)
         return defaultBoxRectRange; // Default box rectangle range
 }
 
+bool unprojectRelationView(GLint framebuffer, double localX, double localY, double &outX, double &outY)
+{
+    RelationViewTransform transform;
+    {
+        std::lock_guard<std::mutex> lock(gTransformMutex);
+
+        auto it = gRelationViewTransforms.find(framebuffer);
+        if (it == gRelationViewTransforms.end())
+            return false;
+
+        transform = it->second;
+    }
+
+    const std::array<GLint, 4> &viewport = transform.viewport;
+    if (viewport[2] <= 0 || viewport[3] <= 0)
+        return false;
+
+    // Same as gluUnProject: inverse(projection * modelview) applied to the normalized device coordinates
+    std::array<GLdouble, 16> inverse;
+    if (!invertMatrix4(multiplyMatrix4(transform.projection, transform.modelview), inverse))
+        return false;
+
+    // Flip y as the origin of the OpenGL window coordinates is at the bottom-left, and use the near plane(winZ = 0.0)
+    const GLdouble winY = viewport[3] - localY;
+    const GLdouble ndc[4] = {(localX - viewport[0]) / viewport[2] * 2.0 - 1.0,
+                             (winY - viewport[1]) / viewport[3] * 2.0 - 1.0,
+                             -1.0,
+                             1.0};
+
+    GLdouble unprojected[4];
+    for (int row = 0; row < 4; ++row)
+    {
+        unprojected[row] = 0.0;
+        for (int k = 0; k < 4; ++k)
+            unprojected[row] += inverse[k * 4 + row] * ndc[k];
+    }
+
+    if (unprojected[3] == 0.0)
+        return false;
+
+    outX = unprojected[0] / unprojected[3];
+    outY = unprojected[1] / unprojected[3];
+    return true;
+}
+
 bool startHook()
 {
     DetourTransactionBegin();
@@ -87,6 +397,7 @@ bool startHook()
 
     // Attach custom functions to the original OpenGL functions
     DetourAttach(&(PVOID &)glBindFramebufferTrue, glBindFramebufferCustom);
+    DetourAttach(&(PVOID &)glDeleteFramebuffersTrue, glDeleteFramebuffersCustom);
     DetourAttach(&(PVOID &)glBeginTrue, glBeginCustom);
     DetourAttach(&(PVOID &)glRectfTrue, glRectfCustom);
     DetourAttach(&(PVOID &)glVertex2dTrue, glVertex2dCustom);
@@ -106,6 +417,7 @@ void endHook()
 
     // Detach custom functions from the original OpenGL functions
     DetourDetach(&(PVOID &)glBindFramebufferTrue, glBindFramebufferCustom);
+    DetourDetach(&(PVOID &)glDeleteFramebuffersTrue, glDeleteFramebuffersCustom);
     DetourDetach(&(PVOID &)glBeginTrue, glBeginCustom);
     DetourDetach(&(PVOID &)glRectfTrue, glRectfCustom);
     DetourDetach(&(PVOID &)glVertex2dTrue, glVertex2dCustom);
@@ -117,21 +429,118 @@ void endHook()
 
 void glBindFramebufferCustom(GLenum target, GLuint framebuffer)
 {
-    std::lock_guard<std::recursive_mutex> lock(gFramebufferMutex);
+    RelationViewFrameStatsListener listener;
+    RelationViewFrameStats completedFrameStats;
+    GLint completedFramebuffer = -1;
+    std::vector<RelationViewFrameCallback> frameCallbacks;
 
-    GLint newFrameBuffer = static_cast<GLint>(framebuffer);
-
-    if (gCurrentRelationViewFramebuffer != newFrameBuffer)
     {
-        // Update the current framebuffer
-        gCurrentRelationViewFramebuffer = newFrameBuffer;
+        std::lock_guard<std::recursive_mutex> lock(gFramebufferMutex);
+
+        GLint newFrameBuffer = static_cast<GLint>(framebuffer);
+
+        if (gCurrentRelationViewFramebuffer != newFrameBuffer)
+        {
+            // The relation view frame is completed when another framebuffer is bound
+            if (gIsRelationViewFrameActive)
+            {
+                gIsRelationViewFrameActive = false;
 
-        // Request data reset for new capture in the next glBegin call
-        gIsDataResetRequired = true;
+                completedFrameStats.drawTimeMs = std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - gFrameStartTime).count();
+                completedFrameStats.rectCount = gFrameRectCount;
+                completedFrameStats.vertexCount = gFrameVertexCount;
+                completedFrameStats.beginEndCount = gFrameBeginEndCount;
+
+                // Ignore binds without any drawing (e.g. only reading the framebuffer for composition),
+                // and frames of unknown framebuffers which turned out not to be relation views
+                auto it = gFramebufferClasses.find(gCurrentRelationViewFramebuffer);
+                bool isRelationView = it != gFramebufferClasses.end() && it->second.type == FramebufferClass::RelationView;
+
+                if (isRelationView && (completedFrameStats.beginEndCount > 0 || completedFrameStats.rectCount > 0))
+                {
+                    completedFramebuffer = gCurrentRelationViewFramebuffer;
+                    listener = gFrameStatsListener;
+
+                    // Take out the callbacks waiting for this framebuffer or any relation view
+                    auto pendingEnd = std::partition(gPendingFrameCallbacks.begin(), gPendingFrameCallbacks.end(),
+                                                     [completedFramebuffer](const PendingFrameCallback &pending)
+                                                     { return pending.framebuffer != -1 && pending.framebuffer != completedFramebuffer; });
+
+                    for (auto pending = pendingEnd; pending != gPendingFrameCallbacks.end(); ++pending)
+                        frameCallbacks.push_back(std::move(pending->callback));
+
+                    gPendingFrameCallbacks.erase(pendingEnd, gPendingFrameCallbacks.end());
+                }
+            }
+
+            // Update the current framebuffer
+            gCurrentRelationViewFramebuffer = newFrameBuffer;
+
+            // Capture only for relation views, or for unknown framebuffers while probing them
+            FramebufferClass framebufferClass = classifyBoundFramebuffer(newFrameBuffer);
+            bool isRelationViewCandidate = framebufferClass != FramebufferClass::Other;
+            gIsRelationViewRendering = isRelationViewCandidate;
+
+            // Request data reset for new capture in the next glBegin call
+            gIsDataResetRequired = isRelationViewCandidate;
+
+            if (!isRelationViewCandidate)
+            {
+                gIsCapturingGridLines = false;
+                gIsSpacingCalculationRequired = false;
+            }
+
+            // Start counting the draw calls of a new relation view frame
+            // Note: Unknown framebuffers are also counted, as they can be promoted while drawing the grid lines
+            if (isRelationViewCandidate)
+            {
+                gFrameRectCount = 0;
+                gFrameVertexCount = 0;
+                gFrameBeginEndCount = 0;
+                gFrameStartTime = std::chrono::steady_clock::now();
+                gIsRelationViewFrameActive = true;
+            }
+        }
     }
 
     // Call the original glBindFramebuffer function
     glBindFramebufferTrue(target, framebuffer);
+
+    // Notify outside of the lock, so that the listener and callbacks can call the functions of this module
+    if (listener)
+        listener(completedFramebuffer, completedFrameStats);
+
+    for (const RelationViewFrameCallback &callback : frameCallbacks)
+        callback(completedFramebuffer);
+}
+
+void glDeleteFramebuffersCustom(GLsizei n, const GLuint *framebuffers)
+{
+    if (framebuffers)
+    {
+        std::lock_guard<std::recursive_mutex> lock(gFramebufferMutex);
+
+        // Framebuffer IDs can be reused by the driver, so forget everything known about the deleted ones
+        for (GLsizei i = 0; i < n; ++i)
+        {
+            GLint deletedFramebuffer = static_cast<GLint>(framebuffers[i]);
+            gFramebufferClasses.erase(deletedFramebuffer);
+            eraseFramebufferData(deletedFramebuffer);
+
+            // The deleted framebuffer will never complete a frame, so its callbacks would wait forever
+            gPendingFrameCallbacks.erase(std::remove_if(gPendingFrameCallbacks.begin(), gPendingFrameCallbacks.end(),
+                                                        [deletedFramebuffer](const PendingFrameCallback &pending)
+                                                        { return pending.framebuffer == deletedFramebuffer; }),
+                                         gPendingFrameCallbacks.end());
+
+            // Classify again on the next bind even if the same ID is reused
+            if (gCurrentRelationViewFramebuffer == deletedFramebuffer)
+                gCurrentRelationViewFramebuffer = -1;
+        }
+    }
+
+    // Call the original glDeleteFramebuffers function
+    glDeleteFramebuffersTrue(n, framebuffers);
 }
 
 void WINAPI glBeginCustom(GLenum mode)
@@ -158,6 +567,19 @@ void WINAPI glBeginCustom(GLenum mode)
         else
             gBoxRectRange.insert({gCurrentRelationViewFramebuffer, defaultBoxRectRange});
 
+        // Capture the transform state of the relation view, so that the plugin can unproject
+        // positions later without making the context current
+        // Note: glGet* must be called outside glBegin/glEnd, so this is done before calling the original glBegin
+        RelationViewTransform transform;
+        glGetDoublev(GL_MODELVIEW_MATRIX, transform.modelview.data());
+        glGetDoublev(GL_PROJECTION_MATRIX, transform.projection.data());
+        glGetIntegerv(GL_VIEWPORT, transform.viewport.data());
+
+        {
+            std::lock_guard<std::mutex> transformLock(gTransformMutex);
+            gRelationViewTransforms[gCurrentRelationViewFramebuffer] = transform;
+        }
+
         // Start capturing grid line coordinates
         gIsCapturingGridLines = true;
 
@@ -174,8 +596,12 @@ void WINAPI glEndCustom(void)
     // Call the original glEnd function
     glEndTrue();
 
+    if (gIsRelationViewFrameActive)
+        ++gFrameBeginEndCount;
+
     if (gIsSpacingCalculationRequired)
     {
+        std::lock_guard<std::recursive_mutex> framebufferLock(gFramebufferMutex);
         std::lock_guard<std::mutex> lock(gGridLineMutex);
 
         if (gGridLineXCoords.find(gCurrentRelationViewFramebuffer) == gGridLineXCoords.end())
@@ -186,6 +612,19 @@ void WINAPI glEndCustom(void)
 
         if (gGridLineXCoords[gCurrentRelationViewFramebuffer].size() >= 5)
         {
+            // Promote the framebuffer being probed if the grid lines of the relation view are detected
+            auto it = gFramebufferClasses.find(gCurrentRelationViewFramebuffer);
+            if (it != gFramebufferClasses.end() && it->second.type == FramebufferClass::Unknown)
+            {
+                if (!matchesGridLineSignature(gGridLineXCoords[gCurrentRelationViewFramebuffer]))
+                {
+                    gIsSpacingCalculationRequired = false;
+                    return;
+                }
+
+                it->second.type = FramebufferClass::RelationView;
+            }
+
             // Ignore the first three coordinate, calculate spacing using the 4th and 5th coordinates
             // to ensure precise spacing calculation while panning, scaling, or resizing the relation view.
             double calculatedSpacing = gGridLineXCoords[gCurrentRelationViewFramebuffer][4] - gGridLineXCoords[gCurrentRelationViewFramebuffer][3];
@@ -212,6 +651,16 @@ void WINAPI glEndCustom(void)
 
 void WINAPI glRectfCustom(GLfloat x1, GLfloat y1, GLfloat x2, GLfloat y2)
 {
+    // Ignore when not in relation view rendering
+    if (!gIsRelationViewRendering)
+    {
+        glRectfTrue(x1, y1, x2, y2);
+        return;
+    }
+
+    if (gIsRelationViewFrameActive)
+        ++gFrameRectCount;
+
     std::lock_guard<std::mutex> gridLock(gGridLineMutex);
 
     // Epsilon for comparison of floating point numbers
@@ -224,7 +673,7 @@ void WINAPI glRectfCustom(GLfloat x1, GLfloat y1, GLfloat x2, GLfloat y2)
     else
         currentGridSpacing = defaultGLGridSpacing;
 
-    // Ignore when not in relation view rendering and small rectangles(connectors, not boxes itself)
+    // Ignore small rectangles(connectors, not boxes itself)
     // The value 17.7 seems to be the width(height) of the connector part of a box when grid spacing is default defaultGLGridSpacing
     if ((x2 - x1) <= 17.7 / defaultGLGridSpacing * currentGridSpacing + e)
     {
@@ -264,6 +713,9 @@ void WINAPI glRectfCustom(GLfloat x1, GLfloat y1, GLfloat x2, GLfloat y2)
 
 void WINAPI glVertex2dCustom(GLdouble x, GLdouble y)
 {
+    if (gIsRelationViewFrameActive)
+        ++gFrameVertexCount;
+
     if (gIsCapturingGridLines)
     {
         std::lock_guard<std::mutex> lock(gGridLineMutex);
@@ -1,6 +1,7 @@
 #pragma once
 
 #include <array>
+#include <functional>
 
 #include <Windows.h>
 #include <gl/GL.h>
@@ -34,6 +35,88 @@ double getLastGridSpacing(GLint framebuffer);
  */
 std::array<double, 4> getBoxRectRange(GLint framebuffer);
 
+/**
+ * @struct RelationViewFrameStats
+ * @brief Draw statistics of one frame rendered into a relation view framebuffer
+ */
+struct RelationViewFrameStats
+{
+    double drawTimeMs = 0.0;        //!< CPU time in milliseconds from binding to unbinding the framebuffer
+    unsigned int rectCount = 0;     //!< Number of glRectf calls
+    unsigned int vertexCount = 0;   //!< Number of glVertex2d calls
+    unsigned int beginEndCount = 0; //!< Number of glBegin/glEnd pairs
+};
+
+/**
+ * @typedef RelationViewFrameStatsListener
+ * @brief Function type notified of each completed relation view frame
+ * @param framebuffer The framebuffer of the relation view
+ * @param stats The draw statistics of the completed frame
+ */
+using RelationViewFrameStatsListener = std::function<void(GLint framebuffer, const RelationViewFrameStats &stats)>;
+
+/**
+ * @brief Called by the plugin to set the listener notified of each completed relation view frame
+ * @param listener The listener to set, or nullptr to remove the current listener
+ * @note A frame is completed when another framebuffer is bound after drawing into the relation view framebuffer.
+ *       The listener is called from the rendering thread after the original glBindFramebuffer.
+ */
+void setRelationViewFrameStatsListener(RelationViewFrameStatsListener listener);
+
+/**
+ * @typedef RelationViewFrameCallback
+ * @brief Function type called once when a relation view frame is completed
+ * @param framebuffer The framebuffer of the relation view whose frame has been completed
+ */
+using RelationViewFrameCallback = std::function<void(GLint framebuffer)>;
+
+/**
+ * @typedef RelationViewFrameCallbackId
+ * @brief Identifier of a callback waiting for the next relation view frame, 0 for none
+ */
+using RelationViewFrameCallbackId = unsigned long long;
+
+/**
+ * @brief Called by the plugin to be notified once when the next relation view frame is completed
+ * @param framebuffer The framebuffer of the relation view to wait for, or -1 to wait for any relation view
+ * @param callback The function to call, from the rendering thread after the original glBindFramebuffer
+ * @return The identifier to cancel the callback with, 0 if the callback is empty
+ * @note The callback is called in the middle of the rendering of the application,
+ *       so it should only queue the actual work to the event loop.
+ * @note Callbacks waiting for a framebuffer are discarded when the framebuffer is deleted.
+ */
+RelationViewFrameCallbackId requestNextRelationViewFrameCallback(GLint framebuffer, RelationViewFrameCallback callback);
+
+/**
+ * @brief Called by the plugin to stop waiting for the next relation view frame, e.g. when the wait has timed out
+ * @param callbackId The identifier returned by requestNextRelationViewFrameCallback
+ * @note Nothing happens if the callback has already been called or cancelled.
+ */
+void cancelRelationViewFrameCallback(RelationViewFrameCallbackId callbackId);
+
+/**
+ * @brief Called by the plugin to register a framebuffer owned by a relation view widget
+ * @details The framebuffer is classified as a relation view immediately, without waiting for
+ *          the grid line signature to be detected by the hooks.
+ * @param framebuffer The framebuffer of the QOpenGLWidget which shows the relation view
+ * @note The classification is discarded when the framebuffer is deleted (e.g. the widget is resized).
+ */
+void registerRelationViewFramebuffer(GLint framebuffer);
+
+/**
+ * @brief Called by the plugin to unproject a position in the relation view widget to OpenGL coordinates
+ * @details Uses the modelview/projection matrices and the viewport captured by the hooks while the framebuffer
+ *          was last rendered, so the OpenGL context of the widget does not need to be made current.
+ * @param framebuffer The framebuffer used by the relation view
+ * @param localX The x coordinate in the widget (origin at the top-left, as in Qt)
+ * @param localY The y coordinate in the widget (origin at the top-left, as in Qt)
+ * @param outX Output parameter to receive the x coordinate in the OpenGL coordinate system
+ * @param outY Output parameter to receive the y coordinate in the OpenGL coordinate system
+ * @return true if unprojection is successful, false if no transform has been captured for the framebuffer
+ *         or the captured transform is not invertible
+ */
+bool unprojectRelationView(GLint framebuffer, double localX, double localY, double &outX, double &outY);
+
 /**
  * @brief Called by the plugin to start hooking the OpenGL functions
  * @details Attaches custom functions to OpenGL functions.
@@ -50,15 +133,17 @@ void endHook();
 /**
  * @brief Detour function for OpenGL glBindFramebuffer
  * @details Detects binding of the specific framebuffer to identify relation view rendering context.
+ *          Each framebuffer is classified once and the result is cached per framebuffer ID.
  * @param target The target parameter passed to glBindFramebuffer
  * @param framebuffer The framebuffer parameter passed to glBindFramebuffer
- * @note Set gIsRelationViewRendering and gIsDataResetRequired flags when the framebuffer ID
- *       used by the relation view is detected.
+ * @note Set gIsRelationViewRendering and gIsDataResetRequired flags only when the framebuffer ID
+ *       used by the relation view (or a framebuffer not classified yet) is detected.
  */
 void glBindFramebufferCustom(GLenum target, GLuint framebuffer);
 
 /**
  * @brief Detour function for OpenGL glDeleteFramebuffers
+ * @details Discards the cached classification and captured data of the deleted framebuffers.
  * @param n The n parameter passed to glDeleteFramebuffers
  * @param framebuffers The framebuffers parameter passed to glDeleteFramebuffers
  * @note This monitors the change of framebuffer used by the relation view.
@@ -69,8 +154,8 @@ void glDeleteFramebuffersCustom(GLsizei n, const GLuint *framebuffers);
  * @brief Detour function for OpenGL glBegin
  * @details Detects mode GL_LINES to start capturing vertex data for grid line spacing calculation.
  * @param mode The mode parameter passed to glBegin
- * @note If gIsRelationViewRendering and gIsDataResetRequired are true, reset internal data for new capture
- *       and set gIsCapturingGridLines flag to true.
+ * @note If gIsRelationViewRendering and gIsDataResetRequired are true, reset internal data for new capture,
+ *       capture the transform state of the relation view and set gIsCapturingGridLines flag to true.
  */
 void WINAPI glBeginCustom(GLenum mode);
 
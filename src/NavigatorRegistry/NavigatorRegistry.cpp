@@ -0,0 +1,111 @@
+#include "NavigatorRegistry.h"
+
+#include "Utility.h"
+
+QList<QDockWidget *> NavigatorRegistry::refresh(QMainWindow *mainwindow)
+{
+    // Gather all constraint navigators (both floating and docked)
+    QList<QDockWidget *> foundNavigators;
+    foundNavigators.append(getFloatingConstraintNavigators());
+    foundNavigators.append(getDockedConstraintNavigators(mainwindow));
+
+    // Registration is skipped for the navigators already registered, so duplicate entries are harmless
+    for (QDockWidget *navigator : foundNavigators)
+        registerNavigator(navigator);
+
+    return mNavigators.keys();
+}
+
+QOpenGLWidget *NavigatorRegistry::getRelationView(QDockWidget *navigator)
+{
+    auto it = mNavigators.find(navigator);
+    if (it == mNavigators.end())
+        return nullptr;
+
+    // The relation view is created after the navigator, so resolve it lazily
+    if (!it.value())
+        it.value() = resolveRelationView(navigator);
+
+    return it.value();
+}
+
+QOpenGLWidget *NavigatorRegistry::getRelationViewUnderMouse()
+{
+    if (mRelationViewUnderMouse && mRelationViewUnderMouse->underMouse())
+        return mRelationViewUnderMouse;
+
+    // Fallback: the Enter event is not delivered if the mouse cursor was already over the widget when it was registered
+    for (auto it = mNavigators.begin(); it != mNavigators.end(); ++it)
+    {
+        if (!it.value())
+            it.value() = resolveRelationView(it.key());
+
+        if (it.value() && it.value()->underMouse())
+        {
+            mRelationViewUnderMouse = it.value();
+            return mRelationViewUnderMouse;
+        }
+    }
+
+    return nullptr;
+}
+
+bool NavigatorRegistry::eventFilter(QObject *obj, QEvent *pEvent)
+{
+    switch (pEvent->type())
+    {
+    case QEvent::Enter:
+        if (QOpenGLWidget *widget = qobject_cast<QOpenGLWidget *>(obj))
+            mRelationViewUnderMouse = widget;
+        break;
+
+    case QEvent::Leave:
+        if (obj == mRelationViewUnderMouse)
+            mRelationViewUnderMouse = nullptr;
+        break;
+
+    case QEvent::ChildPolished:
+    case QEvent::ChildRemoved:
+    {
+        // The content of the navigator has changed, look for the relation view again
+        QDockWidget *navigator = qobject_cast<QDockWidget *>(obj);
+        auto it = mNavigators.find(navigator);
+        if (it != mNavigators.end())
+            it.value() = resolveRelationView(navigator);
+        break;
+    }
+
+    default:
+        break;
+    }
+
+    return false;
+}
+
+void NavigatorRegistry::registerNavigator(QDockWidget *navigator)
+{
+    if (!navigator || mNavigators.contains(navigator))
+        return;
+
+    mNavigators.insert(navigator, resolveRelationView(navigator));
+    navigator->installEventFilter(this);
+
+    // Unregister the navigator when it is destroyed
+    connect(navigator, &QObject::destroyed, this, [this, navigator]()
+            { mNavigators.remove(navigator); });
+}
+
+QOpenGLWidget *NavigatorRegistry::resolveRelationView(QDockWidget *navigator)
+{
+    QOpenGLWidget *widget = navigator ? navigator->findChild<QOpenGLWidget *>() : nullptr;
+
+    // Track Enter/Leave events of the relation view
+    // Note: installing the same filter again only moves it to the front of the filter list
+    if (widget)
+    {
+        widget->installEventFilter(this);
+        emit relationViewFound(navigator, widget);
+    }
+
+    return widget;
+}
\ No newline at end of file
@@ -0,0 +1,116 @@
+#pragma once
+
+#include <QtCore/QEvent>
+#include <QtCore/QHash>
+#include <QtCore/QList>
+#include <QtCore/QObject>
+#include <QtCore/QPointer>
+#include <QtCore/QtConfig>
+#include <QtWidgets/QDockWidget>
+#include <QtWidgets/QMainWindow>
+
+#if QT_VERSION_MAJOR >= 6
+#include <QtOpenGLWidgets/QOpenGLWidget>
+#else
+#include <QtWidgets/QOpenGLWidget>
+#endif
+
+/**
+ * @class NavigatorRegistry
+ * @brief Registry of Constraint Navigator dock widgets and the QOpenGLWidgets showing their relation views
+ * @details Implemented as a singleton. Navigators are registered by scanning the widget tree only when the main window
+ *          reports new children, and the registry is kept up to date with ChildPolished/ChildRemoved events of the
+ *          navigators and QObject::destroyed signals. The relation view under the mouse cursor is tracked
+ *          with Enter/Leave events, so key handling does not need to scan the widget tree.
+ */
+class NavigatorRegistry : public QObject
+{
+    Q_OBJECT
+
+public:
+    /**
+     * @brief Get the singleton instance of the NavigatorRegistry
+     * @return Reference to the singleton instance
+     */
+    static NavigatorRegistry &getInstance()
+    {
+        static NavigatorRegistry instance;
+        return instance;
+    }
+
+    /**
+     * @brief Scan for Constraint Navigators (both floating and docked) and register the new ones
+     * @param mainwindow Pointer to the QMainWindow where the docked navigators are located
+     * @return List of all registered navigators
+     * @note If mainwindow is nullptr, the main window is found automatically.
+     */
+    QList<QDockWidget *> refresh(QMainWindow *mainwindow = nullptr);
+
+    /**
+     * @brief Get the registered navigators without scanning the widget tree
+     * @return List of all registered navigators
+     */
+    QList<QDockWidget *> getNavigators() const { return mNavigators.keys(); }
+
+    /**
+     * @brief Get the QOpenGLWidget which shows the relation view of the navigator
+     * @param navigator The navigator dock widget
+     * @return Pointer to the QOpenGLWidget, or nullptr if the navigator is not registered or shows no relation view
+     */
+    QOpenGLWidget *getRelationView(QDockWidget *navigator);
+
+    /**
+     * @brief Get the registered relation view QOpenGLWidget under the mouse cursor
+     * @return Pointer to the QOpenGLWidget, or nullptr if the mouse cursor is not over any relation view
+     */
+    QOpenGLWidget *getRelationViewUnderMouse();
+
+signals:
+    /**
+     * @brief Signal emitted when the QOpenGLWidget of a relation view is found within a registered navigator
+     * @param navigator The navigator dock widget
+     * @param widget The QOpenGLWidget which shows the relation view
+     * @note This may be emitted again for the same widget when the content of the navigator changes.
+     */
+    void relationViewFound(QDockWidget *navigator, QOpenGLWidget *widget);
+
+protected:
+    /**
+     * @brief Event filter method
+     * @details Tracks Enter/Leave events of the relation views and ChildPolished/ChildRemoved events of the navigators.
+     * @param obj The object receiving the event
+     * @param pEvent The event to be processed
+     * @return Always returns false to avoid blocking the default event processing
+     */
+    bool eventFilter(QObject *obj, QEvent *pEvent) override;
+
+private:
+    /**
+     * @brief Singleton constructor
+     * @param parent The parent QObject, default is nullptr
+     */
+    NavigatorRegistry(QObject *parent = nullptr) : QObject(parent) {}
+
+    /// @cond
+    NavigatorRegistry(const NavigatorRegistry &) = delete;
+    NavigatorRegistry &operator=(const NavigatorRegistry &) = delete;
+    /// @endcond
+
+    /**
+     * @brief Register the navigator if it is not registered yet
+     * @param navigator The navigator dock widget
+     */
+    void registerNavigator(QDockWidget *navigator);
+
+    /**
+     * @brief Find the QOpenGLWidget of the relation view within the navigator and start tracking it
+     * @details Emits relationViewFound if the widget is found.
+     * @param navigator The navigator dock widget
+     * @return Pointer to the QOpenGLWidget, or nullptr if not found
+     */
+    QOpenGLWidget *resolveRelationView(QDockWidget *navigator);
+
+private:
+    QHash<QDockWidget *, QPointer<QOpenGLWidget>> mNavigators; //!< Registered navigators and their relation view widgets
+    QPointer<QOpenGLWidget> mRelationViewUnderMouse;            //!< The relation view the mouse cursor has entered last
+};
\ No newline at end of file
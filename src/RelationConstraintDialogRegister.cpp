@@ -2,8 +2,10 @@
 #include "CustomEventFilters.h"
 #include "GLHooks.h"
 #include "RelationDialogManager.h"
+#include "SearchDialog.h"
 #include "Utility.h"
 
+#include <QtCore/QTimer>
 #include <QtWidgets/QMainWindow>
 
 #include <fbsdk/fbsdk.h>
@@ -47,8 +49,12 @@ bool FBLibrary::LibReady()
     mainwindow->installEventFilter(mainwindowFilter);
     DIALOG_DEBUG_MESSAGE("MainWindow filter successfully installed.");
 
+    // Prewarm the SearchDialog after the startup, so the first Tab key press opens it without the setup cost
+    QTimer::singleShot(0, mainwindow, []()
+                       { SearchDialog::getInstance(); });
+
     // Install the Constraint Navigator's event filters
-    if (!installNavigatorConstraintFilters())
+    if (installNavigatorConstraintFilters().isEmpty())
     {
         DIALOG_DEBUG_END_FAILURE;
         return false;
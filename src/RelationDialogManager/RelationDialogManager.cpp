@@ -1,7 +1,16 @@
 #include "RelationDialogManager.h"
 
-#include <QtCore/QSet>
+#include <algorithm>
+#include <cmath>
+#include <unordered_set>
+#include <utility>
+#include <vector>
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QTimer>
 #include <QtCore/QtConfig>
+#include <QtGui/QCursor>
+#include <QtWidgets/QApplication>
 
 #if QT_VERSION_MAJOR >= 6
 #include <QtOpenGLWidgets/QOpenGLWidget>
@@ -11,9 +20,55 @@
 
 #include "ConfigReadWriter.h"
 #include "CustomEventFilters.h"
+#include "NavigatorRegistry.h"
+#include "RelationViewStateStore.h"
 #include "SuggestionProvider.h"
 #include "Utility.h"
 
+/**
+ * @brief Helper function to install the RelationOpenGLWidgetFilter on the QOpenGLWidget of a relation view
+ * @param glWidget The QOpenGLWidget which shows the relation view
+ * @note QObject::installEventFilter does not install the same filter twice, so this can be called repeatedly.
+ */
+static void installRelationOpenGLWidgetFilterOn(QOpenGLWidget *glWidget)
+{
+    if (!glWidget)
+        return;
+
+    glWidget->installEventFilter(&RelationOpenGLWidgetFilter::getInstance());
+    RelationOpenGLWidgetFilter::getInstance().trackRelationView(glWidget);
+
+    // Let the GL hooks classify the framebuffer of this widget as a relation view without probing
+    registerRelationViewFramebuffer(static_cast<GLint>(glWidget->defaultFramebufferObject()));
+}
+
+/**
+ * @brief Helper function to mark the suggestion data outdated when a model or a relation constraint has changed
+ * @param plugHandle Handle to the plug which has been added to or removed from the scene, or renamed
+ */
+static void markSuggestionsStaleFor(const HdlFBPlug &plugHandle)
+{
+    if (!plugHandle.Ok())
+        return;
+
+    if (plugHandle->Is(FBModel::TypeInfo))
+        SuggestionProvider::getInstance().markModelSuggestionsStale();
+    else if (plugHandle->Is(FBConstraintRelation::TypeInfo))
+    {
+        SuggestionProvider::getInstance().markMacroSuggestionsStale();
+        invalidateConstraintRelationNameIndex();
+    }
+}
+
+/**
+ * @brief Helper function to get the file path of the current scene
+ * @return The file path, or an empty string if the scene has never been saved
+ */
+static std::string getScenePath()
+{
+    return FBApplication::TheOne().FBXFileName.AsString();
+}
+
 FBRegisterCustomManager(RelationDialogManager);
 FBCustomManagerImplementation(RelationDialogManager);
 
@@ -56,18 +111,12 @@ bool RelationDialogManager::Clear()
     // Clear internal data
     mLastSelectedRelationConstraint = nullptr;
     mRelationViewStates.clear();
+    publishRelationViewSnapshot();
 
-    return true;
-}
-
-FBConstraintRelation *RelationDialogManager::getLastSelectedRelationConstraint()
-{
-    std::lock_guard<std::mutex> lock(mRelationMutex);
-
-    if (mLastSelectedRelationConstraint.Ok())
-        return mLastSelectedRelationConstraint;
+    std::lock_guard<std::mutex> profileLock(mRenderProfileMutex);
+    mRelationRenderProfiles.clear();
 
-    return nullptr;
+    return true;
 }
 
 void RelationDialogManager::eventConnectionSetup()
@@ -76,40 +125,196 @@ void RelationDialogManager::eventConnectionSetup()
         return;
 
     // Connect callbacks to system events
-    FBSystem::TheOne().OnUIIdle.Add(this, (FBCallback)&RelationDialogManager::onUIIdle);
     FBSystem::TheOne().OnConnectionStateNotify.Add(this, (FBCallback)&RelationDialogManager::onRelationSelected);
     FBSystem::TheOne().OnConnectionNotify.Add(this, (FBCallback)&RelationDialogManager::onRelationDeleted);
+    FBApplication::TheOne().OnFileOpen.Add(this, (FBCallback)&RelationDialogManager::onFileLoadStarted);
+    FBApplication::TheOne().OnFileMerge.Add(this, (FBCallback)&RelationDialogManager::onFileLoadStarted);
     FBApplication::TheOne().OnFileOpenCompleted.Add(this, (FBCallback)&RelationDialogManager::onMergeCompleted);
+    FBApplication::TheOne().OnFileNewCompleted.Add(this, (FBCallback)&RelationDialogManager::onFileNewCompleted);
     FBApplication::TheOne().OnFileExit.Add(this, (FBCallback)&RelationDialogManager::onShutDown);
 
+    // Install the event filter as soon as the registry finds a relation view
+    NavigatorRegistry *registry = &NavigatorRegistry::getInstance();
+    mRelationViewFoundConnection = QObject::connect(registry, &NavigatorRegistry::relationViewFound, registry,
+                                                    [](QDockWidget *, QOpenGLWidget *widget)
+                                                    { installRelationOpenGLWidgetFilterOn(widget); });
+
+    // Receive the draw statistics of the relation view from the GL hooks
+    setRelationViewFrameStatsListener([this](GLint framebuffer, const RelationViewFrameStats &stats)
+                                      { onRelationViewFrameCompleted(framebuffer, stats); });
+
     eventConnectionSetupFinished = true;
 }
 
+void RelationDialogManager::onFileLoadStarted(HISender pSender, HKEvent pEvent)
+{
+    mSkippedEventCount = 0;
+    mIsLoadingFile = true;
+
+    // OnFileOpenCompleted is not sent if the loading fails or is cancelled, so watch the load phase
+    scheduleLoadPhaseCheck(++mLoadPhaseGeneration, 0);
+}
+
 void RelationDialogManager::onMergeCompleted(HISender pSender, HKEvent pEvent)
 {
-    // Request installation of the event filter in the next UI idle event
-    installRequired = true;
+    endLoadPhase();
+
+    // Request installation of the event filter
+    setFilterInstallRequired();
+}
+
+void RelationDialogManager::onFileNewCompleted(HISender pSender, HKEvent pEvent)
+{
+    // A new scene replaces the one whose loading might not have been completed
+    endLoadPhase();
+}
+
+void RelationDialogManager::endLoadPhase()
+{
+    if (!mIsLoadingFile.exchange(false))
+        return;
+
+    DIALOG_DEBUG_START;
+
+    // Apply the changes skipped during the load phase at once
+    reconcileAfterFileLoad();
+
+    // The scene content has changed without notifications, so warm up the suggestion data from scratch
+    SuggestionProvider::getInstance().markModelSuggestionsStale();
+    SuggestionProvider::getInstance().markMacroSuggestionsStale();
+    SuggestionProvider::getInstance().requestWarmUp();
+    invalidateConstraintRelationNameIndex();
+
+    DIALOG_DEBUG_MESSAGE("File loading completed. Connection events skipped: %llu", mSkippedEventCount.load());
+    DIALOG_DEBUG_END_NOTFAILURE;
+}
+
+void RelationDialogManager::scheduleLoadPhaseCheck(unsigned long long generation, unsigned long long skippedEventCount)
+{
+    QTimer::singleShot(loadPhaseCheckIntervalMs, QCoreApplication::instance(), [this, generation, skippedEventCount]()
+                       { checkLoadPhase(generation, skippedEventCount); });
+}
+
+void RelationDialogManager::checkLoadPhase(unsigned long long generation, unsigned long long skippedEventCount)
+{
+    // The load phase has ended, or another one has started with its own check
+    if (mIsShuttingDown || !mIsLoadingFile || generation != mLoadPhaseGeneration)
+        return;
+
+    // Events are still arriving, so the file is still being loaded
+    const unsigned long long currentSkippedEventCount = mSkippedEventCount;
+    if (currentSkippedEventCount != skippedEventCount)
+    {
+        scheduleLoadPhaseCheck(generation, currentSkippedEventCount);
+        return;
+    }
+
+    FBTrace("Relation Constraint Dialog: File loading did not complete, ending the load phase.\n");
+    endLoadPhase();
+    setFilterInstallRequired();
+}
+
+void RelationDialogManager::reconcileAfterFileLoad()
+{
+    // Gather the relation constraints in the scene
+    std::unordered_set<FBConstraintRelation *> sceneRelations;
+    FBConstraintRelation *selectedRelation = nullptr;
+
+    FBScene *scene = FBSystem::TheOne().Scene;
+    for (int i = 0; i < scene->Constraints.GetCount(); ++i)
+    {
+        FBConstraint *constraint = scene->Constraints[i];
+        if (!FBIS(constraint, FBConstraintRelation))
+            continue;
+
+        FBConstraintRelation *relation = (FBConstraintRelation *)constraint;
+        sceneRelations.insert(relation);
+
+        if (!selectedRelation && relation->Selected)
+            selectedRelation = relation;
+    }
+
+    std::lock_guard<std::mutex> lock(mRelationMutex);
+
+    // The selection events were skipped, so take over the selection of the loaded scene
+    if (!mLastSelectedRelationConstraint.Ok() || sceneRelations.count(mLastSelectedRelationConstraint) == 0)
+        mLastSelectedRelationConstraint = selectedRelation;
+
+    if (mLastSelectedRelationConstraint.Ok())
+        restoreRelationViewState(mLastSelectedRelationConstraint);
+
+    // Remove the data of the relation constraints deleted during the load phase
+    size_t removedCount = 0;
+    for (auto it = mRelationViewStates.begin(); it != mRelationViewStates.end();)
+    {
+        if (sceneRelations.count(it->first) == 0)
+        {
+            it = mRelationViewStates.erase(it);
+            removedCount++;
+        }
+        else
+            ++it;
+    }
+
+    publishRelationViewSnapshot();
+
+    std::lock_guard<std::mutex> profileLock(mRenderProfileMutex);
+    for (auto it = mRelationRenderProfiles.begin(); it != mRelationRenderProfiles.end();)
+    {
+        if (sceneRelations.count(it->first) == 0)
+            it = mRelationRenderProfiles.erase(it);
+        else
+            ++it;
+    }
+
+    DIALOG_DEBUG_MESSAGE("Removed stored view states for %zu deleted Relation Constraints.", removedCount);
 }
 
 void RelationDialogManager::onRelationDeleted(HISender pSender, HKEvent pEvent)
 {
+    // Deleted relation constraints are removed in one pass when the file loading is completed
+    if (mIsLoadingFile)
+    {
+        mSkippedEventCount++;
+        return;
+    }
+
     FBEventConnectionNotify connectionEvent(pEvent);
+    if (connectionEvent.Action != kFBConnected && connectionEvent.Action != kFBDisconnected)
+        return;
+
+    // IMPORTANT: Preventing crashes when using FBPropertyBaseComponent's operators which result in accessing dangling pointers
+    // Note: The handles are built once per event and shared by the checks below
+    HdlFBPlug dstPlugHandle(&connectionEvent.DstPlug);
+    if (!dstPlugHandle.Ok())
+        return;
+
+    // Most connections are made between other components, so the destination is checked before the source
+    const bool isSceneConnection = dstPlugHandle->Is(FBScene::TypeInfo);
+    if (!isSceneConnection && !dstPlugHandle->Is(FBConstraintRelation::TypeInfo))
+        return;
+
+    HdlFBPlug srcPlugHandle(&connectionEvent.SrcPlug);
+    if (!srcPlugHandle.Ok())
+        return;
 
-    if (connectionEvent.Action == kFBDisconnected)
+    // Macros added to or removed from relation constraints outdate the warmed-up macro catalog
+    if (!isSceneConnection)
     {
-        // IMPORTANT: Preventing crashes when using FBPropertyBaseComponent's operators which result in accessing dangling pointers
-        HdlFBPlug srcPlugHandle(&connectionEvent.SrcPlug);
-        HdlFBPlug dstPlugHandle(&connectionEvent.DstPlug);
-        if (!srcPlugHandle.Ok() || !dstPlugHandle.Ok())
-            return;
+        if (srcPlugHandle->Is(FBConstraintRelation::TypeInfo))
+            SuggestionProvider::getInstance().markMacroSuggestionsStale();
+        return;
+    }
 
-        // Detect deletion of relation constraints and being removed from the scene
-        if (!srcPlugHandle->Is(FBConstraintRelation::TypeInfo) || !dstPlugHandle->Is(FBScene::TypeInfo))
-            return;
+    // Models and relation constraints added to or removed from the scene outdate the warmed-up suggestion data
+    markSuggestionsStaleFor(srcPlugHandle);
 
+    // Detect deletion of relation constraints and being removed from the scene
+    if (connectionEvent.Action == kFBDisconnected && srcPlugHandle->Is(FBConstraintRelation::TypeInfo))
+    {
         DIALOG_DEBUG_START;
 
-        FBConstraintRelation *relation = (FBConstraintRelation *)(dstPlugHandle.GetPlug());
+        FBConstraintRelation *relation = (FBConstraintRelation *)(srcPlugHandle.GetPlug());
         if (relation)
         {
             DIALOG_DEBUG_MESSAGE("Detected deletion of a Relation Constraint. Constraint Name: %s", relation->Name.AsString());
@@ -127,6 +332,31 @@ void RelationDialogManager::onRelationDeleted(HISender pSender, HKEvent pEvent)
                 mRelationViewStates.erase(it);
                 DIALOG_DEBUG_MESSAGE("Removed stored view state for deleted Relation Constraint.");
             }
+
+            publishRelationViewSnapshot();
+
+            // Remove the views showing the deleted relation constraint, which show the selected one when accessed again
+            for (auto slotIt = mRelationViewSlots.begin(); slotIt != mRelationViewSlots.end();)
+            {
+                if ((FBConstraintRelation *)slotIt->second->relation == relation)
+                {
+                    mRelationViewFramebuffers.erase(slotIt->first);
+                    slotIt = mRelationViewSlots.erase(slotIt);
+                }
+                else
+                    ++slotIt;
+            }
+
+            // Remove the render cost samples and the framebuffers for the deleted relation constraint
+            std::lock_guard<std::mutex> profileLock(mRenderProfileMutex);
+            mRelationRenderProfiles.erase(relation);
+            for (auto framebufferIt = mFramebufferRelations.begin(); framebufferIt != mFramebufferRelations.end();)
+            {
+                if ((FBConstraintRelation *)framebufferIt->second == relation)
+                    framebufferIt = mFramebufferRelations.erase(framebufferIt);
+                else
+                    ++framebufferIt;
+            }
         }
 
         DIALOG_DEBUG_END_NOTFAILURE;
@@ -135,8 +365,23 @@ void RelationDialogManager::onRelationDeleted(HISender pSender, HKEvent pEvent)
 
 void RelationDialogManager::onRelationSelected(HISender pSender, HKEvent pEvent)
 {
+    // The selection is taken over in one pass when the file loading is completed
+    if (mIsLoadingFile)
+    {
+        mSkippedEventCount++;
+        return;
+    }
+
     FBEventConnectionStateNotify connectionStateEvent(pEvent);
 
+    // Renamed models and relation constraints outdate the warmed-up suggestion data
+    if (connectionStateEvent.Action == kFBRenamed)
+    {
+        FBPlug *renamedPlug = connectionStateEvent.Plug;
+        markSuggestionsStaleFor(HdlFBPlug(renamedPlug));
+        return;
+    }
+
     // Note: kFBSelect is sent both when a relation constraint is created and when it is selected
     if (connectionStateEvent.Action == kFBSelect && connectionStateEvent.Plug->Is(FBConstraintRelation::TypeInfo))
     {
@@ -151,126 +396,410 @@ void RelationDialogManager::onRelationSelected(HISender pSender, HKEvent pEvent)
         {
             std::lock_guard<std::mutex> lock(mRelationMutex);
 
-            // If this relation constraint is not already in the map, add it with default view state
-            if (mRelationViewStates.find(relation) == mRelationViewStates.end())
-                mRelationViewStates[relation] = RelationViewState();
+            // If this relation constraint is not already in the map, add it with the persisted or default view state
+            restoreRelationViewState(relation);
 
             // Update the last selected relation constraint if it has changed
             if (relation != mLastSelectedRelationConstraint)
                 mLastSelectedRelationConstraint = relation;
+
+            publishRelationViewSnapshot();
+        }
+
+        // Only the view of the navigator in which the relation constraint was selected shows it
+        if (QCoreApplication *application = QCoreApplication::instance())
+        {
+            auto bindRelation = [this, relationHandle = HdlFBPlugTemplate<FBConstraintRelation>(relation)]() mutable
+            {
+                if (relationHandle.Ok())
+                    bindRelationToSelectingView(relationHandle);
+            };
+            QMetaObject::invokeMethod(application, bindRelation, Qt::QueuedConnection);
         }
 
         DIALOG_DEBUG_MESSAGE("Installing RelationOpenGLWidgetFilter requested.");
 
-        // Request installation of the event filter in the next UI idle event
-        installRequired = true;
+        // Request installation of the event filter
+        setFilterInstallRequired();
+
+        // The selection is a strong signal that the SearchDialog will be opened soon
+        SuggestionProvider::getInstance().requestWarmUp();
 
         DIALOG_DEBUG_END_NOTFAILURE;
     }
 }
 
-void RelationDialogManager::onUIIdle(HISender pSender, HKEvent pEvent)
+void RelationDialogManager::setFilterInstallRequired(const QList<QDockWidget *> &scannedNavigators)
+{
+    QCoreApplication *application = QCoreApplication::instance();
+    if (!application || mIsShuttingDown)
+        return;
+
+    // The system callbacks might not be called in the main thread, so queue the request to the event loop
+    // Note: The navigators might be destroyed before the attempt, so they are held with guarded pointers
+    QList<QPointer<QDockWidget>> guardedNavigators;
+    for (QDockWidget *navigator : scannedNavigators)
+        guardedNavigators.push_back(navigator);
+
+    QMetaObject::invokeMethod(application, [this, guardedNavigators]()
+                              {
+                                  mFilterInstallAttemptCount = 0;
+                                  mScannedNavigators = guardedNavigators;
+                                  if (!mIsFilterInstallScheduled)
+                                      scheduleFilterInstallAttempt(0); }, Qt::QueuedConnection);
+}
+
+void RelationDialogManager::scheduleFilterInstallAttempt(int delayMs)
 {
-    if (!installRequired)
+    mIsFilterInstallScheduled = true;
+    QTimer::singleShot(delayMs, QCoreApplication::instance(), [this]()
+                       { attemptFilterInstall(); });
+}
+
+void RelationDialogManager::attemptFilterInstall()
+{
+    mIsFilterInstallScheduled = false;
+
+    if (mIsShuttingDown)
         return;
 
-    // Look for the constraint navigators
-    QList<QDockWidget *> dockwidgets;
+    // Use the navigators of the scan which requested the installation, otherwise register the navigators
+    // opened since the last discovery, e.g. floating navigators
+    QList<QDockWidget *> navigators;
+    if (!mScannedNavigators.isEmpty())
+    {
+        for (const QPointer<QDockWidget> &navigator : mScannedNavigators)
+        {
+            if (navigator)
+                navigators.push_back(navigator);
+        }
+        mScannedNavigators.clear();
+    }
+    else
+        navigators = NavigatorRegistry::getInstance().refresh();
 
-    // Gather both docked and floating constraint navigators
-    dockwidgets.append(getDockedConstraintNavigators());
-    dockwidgets.append(getFloatingConstraintNavigators());
+    if (installRelationOpenGLWidgetFilter(navigators))
+        return;
 
-    if (dockwidgets.size() == 0)
+    // The relation view might not be created yet, so retry with exponential backoff
+    if (++mFilterInstallAttemptCount >= filterInstallMaxAttemptCount)
+    {
+        DIALOG_DEBUG_START;
+        DIALOG_DEBUG_MESSAGE("No relation view found after %d attempts, RelationOpenGLWidgetFilter installation cancelled.", mFilterInstallAttemptCount);
+        DIALOG_DEBUG_END_NOTFAILURE;
         return;
+    }
+
+    scheduleFilterInstallAttempt(filterInstallFirstRetryDelayMs << (mFilterInstallAttemptCount - 1));
+}
+
+void RelationDialogManager::onRelationViewFrameCompleted(GLint framebuffer, const RelationViewFrameStats &stats)
+{
+    std::lock_guard<std::mutex> lock(mRenderProfileMutex);
+
+    // Attribute the frame to the relation constraint shown by the view, which falls back to the selected one
+    // like getRelationViewSnapshot() if the view has no slot yet or its relation constraint has been deleted
+    FBConstraintRelation *relation = nullptr;
+    auto framebufferIt = mFramebufferRelations.find(framebuffer);
+    if (framebufferIt != mFramebufferRelations.end() && framebufferIt->second.Ok())
+        relation = (FBConstraintRelation *)framebufferIt->second;
+    else
+        relation = getLastSelectedRelationConstraint();
+
+    if (!relation)
+        return;
+
+    auto it = mRelationRenderProfiles.find(relation);
+    if (it == mRelationRenderProfiles.end())
+    {
+        it = mRelationRenderProfiles.emplace(relation, RelationRenderProfile()).first;
+        it->second.relationName = relation->Name.AsString();
+    }
+
+    RelationRenderProfile &profile = it->second;
+    profile.drawTimeMsSamples[profile.nextSampleIndex] = static_cast<float>(stats.drawTimeMs);
+    profile.nextSampleIndex = (profile.nextSampleIndex + 1) % RelationRenderProfile::maxSampleCount;
+    profile.sampleCount = std::min(profile.sampleCount + 1, RelationRenderProfile::maxSampleCount);
+    profile.totalFrameCount++;
+    profile.lastFrameStats = stats;
+}
+
+/**
+ * @brief Helper function to get a percentile of the samples with the nearest-rank method
+ * @param samples The samples, reordered by this function
+ * @param ratio The percentile as a ratio between 0.0 and 1.0
+ * @return The percentile value, or 0.0 if there are no samples
+ */
+static float samplePercentile(std::vector<float> &samples, double ratio)
+{
+    if (samples.empty())
+        return 0.0f;
+
+    size_t rank = static_cast<size_t>(std::ceil(ratio * samples.size()));
+    size_t index = std::min(std::max<size_t>(rank, 1), samples.size()) - 1;
+
+    std::nth_element(samples.begin(), samples.begin() + index, samples.end());
+    return samples[index];
+}
+
+void RelationDialogManager::traceRelationRenderCostReport() const
+{
+    /**
+     * @struct ReportLine
+     * @brief Percentiles and the last draw statistics of a relation for the report
+     */
+    struct ReportLine
+    {
+        const RelationRenderProfile *profile;
+        float p50, p95, p99;
+    };
+
+    std::lock_guard<std::mutex> lock(mRenderProfileMutex);
+
+    std::vector<ReportLine> lines;
+    lines.reserve(mRelationRenderProfiles.size());
+
+    for (const auto &profileEntry : mRelationRenderProfiles)
+    {
+        const RelationRenderProfile &profile = profileEntry.second;
+        std::vector<float> samples(profile.drawTimeMsSamples.begin(), profile.drawTimeMsSamples.begin() + profile.sampleCount);
+
+        ReportLine line;
+        line.profile = &profile;
+        line.p50 = samplePercentile(samples, 0.50);
+        line.p95 = samplePercentile(samples, 0.95);
+        line.p99 = samplePercentile(samples, 0.99);
+        lines.push_back(line);
+    }
+
+    std::sort(lines.begin(), lines.end(), [](const ReportLine &a, const ReportLine &b)
+              { return a.p95 > b.p95; });
+
+    DIALOG_DEBUG_START;
+    DIALOG_DEBUG_MESSAGE("Relation view render cost (latest %zu frames, sorted by p95 draw time):", RelationRenderProfile::maxSampleCount);
+
+    if (lines.empty())
+        DIALOG_DEBUG_MESSAGE("No relation view frames have been recorded yet.");
+
+    for (const ReportLine &line : lines)
+    {
+        const RelationViewFrameStats &last = line.profile->lastFrameStats;
+        DIALOG_DEBUG_MESSAGE("%s: frames=%llu, p50=%.2f ms, p95=%.2f ms, p99=%.2f ms, last frame: rects=%u, vertices=%u, begin/end=%u",
+                             line.profile->relationName.c_str(), line.profile->totalFrameCount, line.p50, line.p95, line.p99,
+                             last.rectCount, last.vertexCount, last.beginEndCount);
+    }
 
-    // Install the RelationOpenGLWidgetFilter on the OpenGL widgets of the found dock widgets
-    installRelationOpenGLWidgetFilter(dockwidgets);
+    DIALOG_DEBUG_END_NOTFAILURE;
 }
 
 void RelationDialogManager::onShutDown(HISender pSender, HKEvent pEvent)
 {
+    // Stop installing the event filter
+    mIsShuttingDown = true;
+    QObject::disconnect(mRelationViewFoundConnection);
+    RelationOpenGLWidgetFilter::getInstance().untrackRelationViews();
+
     // Disconnect callbacks from system events
-    FBSystem::TheOne().OnUIIdle.Remove(this, (FBCallback)&RelationDialogManager::onUIIdle);
     FBSystem::TheOne().OnConnectionStateNotify.Remove(this, (FBCallback)&RelationDialogManager::onRelationSelected);
     FBSystem::TheOne().OnConnectionNotify.Remove(this, (FBCallback)&RelationDialogManager::onRelationDeleted);
+    FBApplication::TheOne().OnFileOpen.Remove(this, (FBCallback)&RelationDialogManager::onFileLoadStarted);
+    FBApplication::TheOne().OnFileMerge.Remove(this, (FBCallback)&RelationDialogManager::onFileLoadStarted);
     FBApplication::TheOne().OnFileOpenCompleted.Remove(this, (FBCallback)&RelationDialogManager::onMergeCompleted);
+    FBApplication::TheOne().OnFileNewCompleted.Remove(this, (FBCallback)&RelationDialogManager::onFileNewCompleted);
+    setRelationViewFrameStatsListener(nullptr);
+
+    // Write the pending relation view states
+    RelationViewStateStore::getInstance().flush();
 
     // Clear internal data
     std::lock_guard<std::mutex> lock(mRelationMutex);
     mLastSelectedRelationConstraint = nullptr;
     mRelationViewStates.clear();
+    publishRelationViewSnapshot();
+
+    mRelationViewSlots.clear();
+    mRelationViewFramebuffers.clear();
+
+    std::lock_guard<std::mutex> profileLock(mRenderProfileMutex);
+    mRelationRenderProfiles.clear();
+    mFramebufferRelations.clear();
 
     // Disconnect from application exit event
     FBApplication::TheOne().OnFileExit.Remove(this, (FBCallback)&RelationDialogManager::onShutDown);
 }
 
-QPoint RelationDialogManager::getRelationViewTopLeftPos() const
+RelationViewSnapshotPtr RelationDialogManager::getRelationViewSnapshot(const QOpenGLWidget *view)
+{
+    if (!view)
+        return getRelationViewSnapshot();
+
+    // The view keeps its relation constraint until a relation constraint is selected in its navigator
+    auto it = mRelationViewSlots.find(view);
+    if (it != mRelationViewSlots.end() && it->second->getRelation())
+        return it->second;
+
+    // First access to this view, or its relation constraint has been deleted
+    RelationViewSnapshotPtr selected = getRelationViewSnapshot();
+    setRelationViewSlot(view, selected);
+    return selected;
+}
+
+void RelationDialogManager::removeRelationView(const QOpenGLWidget *view)
 {
+    mRelationViewSlots.erase(view);
+
+    auto framebufferIt = mRelationViewFramebuffers.find(view);
+    if (framebufferIt == mRelationViewFramebuffers.end())
+        return;
+
+    std::lock_guard<std::mutex> profileLock(mRenderProfileMutex);
+    mFramebufferRelations.erase(framebufferIt->second);
+    mRelationViewFramebuffers.erase(framebufferIt);
+}
+
+bool RelationDialogManager::compareAndSetRelationViewState(const QOpenGLWidget *view, const RelationViewSnapshotPtr &expected, QPoint topLeftPos, double scaleFactor)
+{
+    FBConstraintRelation *relation = expected ? expected->getRelation() : nullptr;
+    if (!relation)
+        return false;
+
+    auto desired = std::make_shared<RelationViewSnapshot>(*expected);
+    desired->topLeftPos = topLeftPos;
+    desired->scaleFactor = scaleFactor;
+
+    if (view)
+    {
+        // Only the state of this view is replaced, other views are not affected
+        auto it = mRelationViewSlots.find(view);
+        if (it == mRelationViewSlots.end() || it->second != expected)
+            return false;
+
+        // Note: The framebuffer is recreated when the view is resized, so it is stored again with the slot
+        setRelationViewSlot(view, desired);
+    }
+
+    // Writers are serialized, so the stored view state is always updated together with the snapshot
     std::lock_guard<std::mutex> lock(mRelationMutex);
 
-    if (mLastSelectedRelationConstraint.Ok())
+    if (!view)
     {
-        auto it = mRelationViewStates.find(mLastSelectedRelationConstraint);
-        if (it != mRelationViewStates.end())
-            return it->second.mCurrentRelationViewTopLeftPos;
+        RelationViewSnapshotPtr current = expected;
+        if (!std::atomic_compare_exchange_strong(&mRelationViewSnapshot, &current, RelationViewSnapshotPtr(desired)))
+            return false;
     }
 
-    return {0, 0};
+    RelationViewState &state = mRelationViewStates[relation];
+    state.mCurrentRelationViewTopLeftPos = topLeftPos;
+    state.mLastScaleFactor = scaleFactor;
+
+    // Persist the state, the file is written later in a batch
+    RelationViewStateStore::getInstance().store(getScenePath(), relation->Name.AsString(), topLeftPos, scaleFactor);
+
+    // Keep the snapshot of the selected relation in sync with the stored state
+    if (view && relation == mLastSelectedRelationConstraint)
+        publishRelationViewSnapshot();
+
+    return true;
 }
 
-double RelationDialogManager::getLastRelationViewScaleFactor() const
+void RelationDialogManager::restoreRelationViewState(FBConstraintRelation *relation)
 {
-    std::lock_guard<std::mutex> lock(mRelationMutex);
+    if (!relation || mRelationViewStates.find(relation) != mRelationViewStates.end())
+        return;
 
-    if (mLastSelectedRelationConstraint.Ok())
+    RelationViewState &state = mRelationViewStates[relation];
+    RelationViewStateStore::getInstance().lookup(getScenePath(), relation->Name.AsString(),
+                                                 state.mCurrentRelationViewTopLeftPos, state.mLastScaleFactor);
+}
+
+RelationViewSnapshotPtr RelationDialogManager::makeRelationViewSnapshot(FBConstraintRelation *relation) const
+{
+    auto snapshot = std::make_shared<RelationViewSnapshot>();
+
+    if (relation)
     {
-        auto it = mRelationViewStates.find(mLastSelectedRelationConstraint);
+        snapshot->relation = relation;
+
+        auto it = mRelationViewStates.find(relation);
         if (it != mRelationViewStates.end())
-            return it->second.mLastScaleFactor;
+        {
+            snapshot->topLeftPos = it->second.mCurrentRelationViewTopLeftPos;
+            snapshot->scaleFactor = it->second.mLastScaleFactor;
+        }
     }
 
-    return 1.0;
+    return snapshot;
 }
 
-void RelationDialogManager::setRelationViewState(QPoint topLeftPos, double scaleFactor)
+void RelationDialogManager::publishRelationViewSnapshot()
 {
-    std::lock_guard<std::mutex> lock(mRelationMutex);
+    FBConstraintRelation *relation = mLastSelectedRelationConstraint.Ok() ? (FBConstraintRelation *)mLastSelectedRelationConstraint : nullptr;
+    std::atomic_store(&mRelationViewSnapshot, makeRelationViewSnapshot(relation));
+}
+
+void RelationDialogManager::bindRelationToSelectingView(FBConstraintRelation *relation)
+{
+    NavigatorRegistry &registry = NavigatorRegistry::getInstance();
+    const QList<QDockWidget *> navigators = registry.getNavigators();
 
-    if (!mLastSelectedRelationConstraint.Ok())
+    // The relation constraint is shown by the navigator in which it was selected,
+    // which has the focus or the mouse cursor
+    QDockWidget *selectingNavigator = nullptr;
+    for (QWidget *activeWidget : {QApplication::focusWidget(), QApplication::widgetAt(QCursor::pos())})
+    {
+        for (QDockWidget *navigator : navigators)
+        {
+            if (!selectingNavigator && activeWidget && navigator->isAncestorOf(activeWidget))
+                selectingNavigator = navigator;
+        }
+    }
+
+    // A selection made elsewhere, e.g. in the scene browser, is only attributed to a single navigator
+    if (!selectingNavigator && navigators.size() == 1)
+        selectingNavigator = navigators.first();
+
+    QOpenGLWidget *view = selectingNavigator ? registry.getRelationView(selectingNavigator) : nullptr;
+    if (!view)
         return;
 
-    auto it = mRelationViewStates.find(mLastSelectedRelationConstraint);
-    if (it != mRelationViewStates.end())
+    RelationViewSnapshotPtr snapshot;
     {
-        it->second.mCurrentRelationViewTopLeftPos = topLeftPos;
-        it->second.mLastScaleFactor = scaleFactor;
+        std::lock_guard<std::mutex> lock(mRelationMutex);
+        snapshot = makeRelationViewSnapshot(relation);
     }
+    setRelationViewSlot(view, snapshot);
+}
+
+void RelationDialogManager::setRelationViewSlot(const QOpenGLWidget *view, RelationViewSnapshotPtr snapshot)
+{
+    const GLint framebuffer = static_cast<GLint>(view->defaultFramebufferObject());
+    FBConstraintRelation *relation = snapshot->getRelation();
+    mRelationViewSlots[view] = std::move(snapshot);
+
+    std::lock_guard<std::mutex> profileLock(mRenderProfileMutex);
+
+    // Forget the previous framebuffer of the view, which has been recreated if the view has been resized
+    auto framebufferIt = mRelationViewFramebuffers.find(view);
+    if (framebufferIt != mRelationViewFramebuffers.end() && framebufferIt->second != framebuffer)
+        mFramebufferRelations.erase(framebufferIt->second);
+
+    mRelationViewFramebuffers[view] = framebuffer;
+    mFramebufferRelations[framebuffer] = relation;
 }
 
 bool RelationDialogManager::installRelationOpenGLWidgetFilter(QList<QDockWidget *> dockwidgets)
 {
     bool success = false;
 
-// Use QSet to avoid duplicate entries
-#if QT_VERSION_MAJOR == 5 && QT_VERSION_MINOR == 12
-    // QSet constructor accepts two iterators is not available in Qt 5.12.5
-    QSet<QDockWidget *> uniqueDockWidgets = QSet<QDockWidget *>::fromList(dockwidgets);
-#else
-    QSet<QDockWidget *> uniqueDockWidgets(dockwidgets.begin(), dockwidgets.end());
-#endif
-
-    for (QDockWidget *dockwidget : uniqueDockWidgets)
+    // Note: The registry avoids duplicate entries
+    for (QDockWidget *dockwidget : dockwidgets)
     {
-        QOpenGLWidget *glWidget = dockwidget->findChild<QOpenGLWidget *>();
+        QOpenGLWidget *glWidget = NavigatorRegistry::getInstance().getRelationView(dockwidget);
         if (!glWidget)
             continue;
 
-        glWidget->installEventFilter(&RelationOpenGLWidgetFilter::getInstance());
+        installRelationOpenGLWidgetFilterOn(glWidget);
         success = true;
-
-        // Reset install request flag
-        installRequired = false;
     }
 
     DIALOG_DEBUG_START;
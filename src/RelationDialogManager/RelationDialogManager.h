@@ -1,15 +1,45 @@
 #pragma once
 
+#include <array>
 #include <atomic>
+#include <memory>
 #include <mutex>
+#include <string>
 #include <unordered_map>
 
 #include <QtCore/QList>
+#include <QtCore/QMetaObject>
 #include <QtCore/QPoint>
+#include <QtCore/QPointer>
 #include <QtWidgets/QDockWidget>
 
 #include <fbsdk/fbsdk.h>
 
+#include "GLHooks.h"
+
+class QOpenGLWidget;
+
+/**
+ * @struct RelationViewSnapshot
+ * @brief Immutable snapshot of the relation view state of the last selected relation constraint
+ * @details Published by RelationDialogManager as a whole, so the relation, position and scale are always consistent.
+ */
+struct RelationViewSnapshot
+{
+    HdlFBPlugTemplate<FBConstraintRelation> relation; //!< Handle to the last selected relation constraint
+    QPoint topLeftPos = {0, 0};                       //!< Top-left position of the relation view
+    double scaleFactor = 1.0;                         //!< Scale factor of the relation view
+
+    /**
+     * @brief Get the relation constraint of this snapshot
+     * @return Pointer to the FBConstraintRelation, or nullptr if none or it has been deleted
+     */
+    FBConstraintRelation *getRelation() const { return relation.Ok() ? (FBConstraintRelation *)relation : nullptr; }
+};
+
+/// Shared pointer to an immutable RelationViewSnapshot
+using RelationViewSnapshotPtr = std::shared_ptr<const RelationViewSnapshot>;
+
 /**
  * @class RelationDialogManager
  * @brief Custom manager that receives system events
@@ -56,28 +86,51 @@ public:
     static RelationDialogManager &getInstance() { return *mInstance; }
 
     /**
-     * @brief Get the last scale factor value of the relation view
-     * @return The last scale factor, or 1.0 if mLastSelectedRelationConstraint is invalid
-     * @note We do not need to pass the currently selected relation constraint as this function internally retrieves it.
+     * @brief Get the last selected relation constraint
+     * @return Pointer to the last selected FBConstraintRelation, or nullptr if none
+     * @note This reads the current snapshot, so no lock is taken.
      */
-    double getLastRelationViewScaleFactor() const;
+    FBConstraintRelation *getLastSelectedRelationConstraint() const { return getRelationViewSnapshot()->getRelation(); }
 
     /**
-     * @brief Get the last selected relation constraint
-     * @return Pointer to the last selected FBConstraintRelation, or nullptr if none
+     * @brief Get the current snapshot of the relation view state
+     * @return Shared pointer to the snapshot, never nullptr
+     * @note No lock is taken. The snapshot is immutable, so read all the values needed from the same snapshot.
+     */
+    RelationViewSnapshotPtr getRelationViewSnapshot() const { return std::atomic_load(&mRelationViewSnapshot); }
+
+    /**
+     * @brief Get the current snapshot of the state of a relation view
+     * @details Each relation view keeps its own relation constraint and state. The relation constraint of a view
+     *          only changes when a relation constraint is selected in its navigator, so selecting in another navigator
+     *          does not affect it. A view accessed for the first time starts with the selected relation constraint.
+     * @param view The QOpenGLWidget which shows the relation view, or nullptr to get the snapshot of the selected relation
+     * @return Shared pointer to the snapshot, never nullptr
+     * @note This must be called from the main thread, like all the accesses to the states of the views.
+     */
+    RelationViewSnapshotPtr getRelationViewSnapshot(const QOpenGLWidget *view);
+
+    /**
+     * @brief Remove the state of a relation view
+     * @param view The QOpenGLWidget which showed the relation view
+     * @note This is called from the main thread when the widget is destroyed.
      */
-    FBConstraintRelation *getLastSelectedRelationConstraint();
+    void removeRelationView(const QOpenGLWidget *view);
 
     /**
-     * @brief Get the current top-left position of the relation view
-     * @return QPoint representing the top-left position, or (0,0) if mLastSelectedRelationConstraint is invalid
-     * @note We do not need to pass the currently selected relation constraint as this function internally retrieves it.
+     * @brief Callback to be connected to FBApplication::OnFileOpen and FBApplication::OnFileMerge events
+     * @details Starts the load phase, in which onRelationSelected and onRelationDeleted skip the events
+     *          until the file loading is completed.
+     * @param pSender The sender of the event
+     * @param pEvent The event data
+     * @note Loading a large scene sends hundreds of thousands of connection events, which are not worth processing one by one.
      */
-    QPoint getRelationViewTopLeftPos() const;
+    void onFileLoadStarted(HISender pSender, HKEvent pEvent);
 
     /**
      * @brief Callback to be connected to FBApplication::OnFileOpenCompleted event
-     * @details Monitors for file merge operation completion and install RelationOpenGLWidgetFilter
+     * @details Ends the load phase and reconciles the internal data with the scene in one pass,
+     *          then monitors for file merge operation completion and install RelationOpenGLWidgetFilter
      * @param pSender The sender of the event
      * @param pEvent The event data
      * @note The content of the navigator window seems to be cleared when a file is merged,
@@ -88,9 +141,19 @@ public:
      */
     void onMergeCompleted(HISender pSender, HKEvent pEvent);
 
+    /**
+     * @brief Callback to be connected to FBApplication::OnFileNewCompleted event
+     * @details Ends the load phase if a file loading was started but never completed, e.g. when it failed or was cancelled.
+     * @param pSender The sender of the event
+     * @param pEvent The event data
+     */
+    void onFileNewCompleted(HISender pSender, HKEvent pEvent);
+
     /**
      * @brief Callback to be connected to FBSystem::OnConnectionNotify event
      * @details Monitors for deletion of relation constraints and removes their stored state.
+     *          Also marks the suggestion data outdated when models or relation constraints are added to or removed from the scene,
+     *          or macros are added to or removed from relation constraints.
      * @param pSender The sender of the event
      * @param pEvent The event data
      */
@@ -98,7 +161,8 @@ public:
 
     /**
      * @brief Callback to be connected to FBSystem::OnConnectionStateNotify event
-     * @details Monitors for creation or selection of relation constraints and sets a flag to install the event filter.
+     * @details Monitors for creation or selection of relation constraints, requests installation of the event filter
+     *          and the warm-up of the suggestion data. Also marks the suggestion data outdated when components are renamed.
      * @param pSender The sender of the event
      * @param pEvent The event data
      * @note It might be more natural to connect to FBSystem::OnConnectionNotify event, but that event is triggered too frequently
@@ -107,13 +171,20 @@ public:
     void onRelationSelected(HISender pSender, HKEvent pEvent);
 
     /**
-     * @brief Callback to be connected to FBSystem::OnUIIdle event
-     * @details Installs the RelationOpenGLWidgetFilter on any detected OpenGLWidgets within Constraint Navigators
-     *          when the installRequired flag is set.
-     * @param pSender The sender of the event
-     * @param pEvent The event data
+     * @brief Listener of the GL hooks notified of each completed relation view frame
+     * @details Attributes the draw statistics to the relation constraint shown by the view of the framebuffer,
+     *          or to the last selected relation constraint if the view has none, and records them in the rolling samples of the relation.
+     * @param framebuffer The framebuffer of the relation view
+     * @param stats The draw statistics of the completed frame
+     */
+    void onRelationViewFrameCompleted(GLint framebuffer, const RelationViewFrameStats &stats);
+
+    /**
+     * @brief Output the render cost of the relation view for each relation constraint with FBTrace
+     * @details Relations are sorted by the 95th percentile of the draw time in descending order,
+     *          so the relations which are worth splitting or simplifying come first.
      */
-    void onUIIdle(HISender pSender, HKEvent pEvent);
+    void traceRelationRenderCostReport() const;
 
     /**
      * @brief Callback to be connected to FBApplication::OnFileExit event
@@ -123,18 +194,27 @@ public:
     void onShutDown(HISender pSender, HKEvent pEvent);
 
     /**
-     * @brief Set the flag to indicate that installation of the event filter is required
-     * @note This is called by the MainWindowFilter when the main layout is changed.
+     * @brief Request installation of the event filter on the relation views
+     * @details Installation is attempted in the event loop, and retried with exponential backoff
+     *          until it succeeds or filterInstallMaxAttemptCount attempts are made.
+     *          Requests made while an attempt is scheduled restart the retry count.
+     * @param scannedNavigators The navigators found by a scan just made, which the next attempt uses instead of scanning again,
+     *                          or an empty list to scan for the navigators
+     * @note This is called by the MainWindowFilter when the main layout is changed. It can be called from any thread.
      */
-    void setFilterInstallRequired() { installRequired = true; }
+    void setFilterInstallRequired(const QList<QDockWidget *> &scannedNavigators = QList<QDockWidget *>());
 
     /**
-     * @brief Store the current state of the relation view
-     * @param topLeftPos The current top-left position of the relation view
-     * @param scaleFactor The current scale factor of the relation view
-     * @note We do not need to pass the currently selected relation constraint as this function internally retrieves it.
+     * @brief Store the state of the relation view if the current snapshot is still the expected one
+     * @details The state is also stored for the relation constraint, so it is restored when the relation is selected again.
+     * @param view The QOpenGLWidget which shows the relation view, or nullptr for the snapshot of the selected relation
+     * @param expected The snapshot the new state was calculated from
+     * @param topLeftPos The new top-left position of the relation view
+     * @param scaleFactor The new scale factor of the relation view
+     * @return true if the state is stored, false if the snapshot has been replaced in the meantime
+     *         (e.g. another relation constraint has been selected) or no relation constraint is selected
      */
-    void setRelationViewState(QPoint topLeftPos, double scaleFactor);
+    bool compareAndSetRelationViewState(const QOpenGLWidget *view, const RelationViewSnapshotPtr &expected, QPoint topLeftPos, double scaleFactor);
 
 private:
     /// @cond
@@ -149,6 +229,86 @@ private:
      */
     bool installRelationOpenGLWidgetFilter(QList<QDockWidget *> dockwidgets);
 
+    /**
+     * @brief Schedule an attempt to install the event filter
+     * @param delayMs Delay in milliseconds before the attempt
+     * @note This must be called from the main thread.
+     */
+    void scheduleFilterInstallAttempt(int delayMs);
+
+    /**
+     * @brief Reconcile the internal data with the scene after the load phase
+     * @details Removes the view states and render profiles of the relation constraints no longer in the scene,
+     *          and validates the last selected relation constraint, falling back to a selected one in the scene.
+     */
+    void reconcileAfterFileLoad();
+
+    /**
+     * @brief End the load phase if it is active, reconcile the internal data and warm up the suggestion data
+     */
+    void endLoadPhase();
+
+    /**
+     * @brief Schedule a check of the load phase after loadPhaseCheckIntervalMs
+     * @param generation The mLoadPhaseGeneration value of the load phase to check
+     * @param skippedEventCount The mSkippedEventCount value when scheduled
+     */
+    void scheduleLoadPhaseCheck(unsigned long long generation, unsigned long long skippedEventCount);
+
+    /**
+     * @brief End the load phase if no connection event has been skipped since the last check
+     * @details OnFileOpenCompleted is not sent if the loading fails or is cancelled. Without this check,
+     *          all the later selection and deletion events would be skipped for the rest of the session.
+     * @param generation The mLoadPhaseGeneration value of the load phase to check
+     * @param skippedEventCount The mSkippedEventCount value when the check was scheduled
+     */
+    void checkLoadPhase(unsigned long long generation, unsigned long long skippedEventCount);
+
+    /**
+     * @brief Add the view state of the relation constraint if it is not stored yet
+     * @details The state persisted in the previous sessions is restored if any, otherwise the default state is used.
+     * @param relation The relation constraint
+     * @note mRelationMutex must be locked by the caller.
+     */
+    void restoreRelationViewState(FBConstraintRelation *relation);
+
+    /**
+     * @brief Publish a new snapshot from mLastSelectedRelationConstraint and its stored view state
+     * @note mRelationMutex must be locked by the caller.
+     */
+    void publishRelationViewSnapshot();
+
+    /**
+     * @brief Make a snapshot of a relation constraint with its stored view state
+     * @param relation The relation constraint, or nullptr for an empty snapshot
+     * @return Shared pointer to the snapshot, never nullptr
+     * @note mRelationMutex must be locked by the caller.
+     */
+    RelationViewSnapshotPtr makeRelationViewSnapshot(FBConstraintRelation *relation) const;
+
+    /**
+     * @brief Store the snapshot shown by a relation view, and the relation constraint drawn into its framebuffer
+     * @param view The QOpenGLWidget which shows the relation view
+     * @param snapshot The snapshot of the relation constraint and its state in the view
+     * @note This must be called from the main thread.
+     */
+    void setRelationViewSlot(const QOpenGLWidget *view, RelationViewSnapshotPtr snapshot);
+
+    /**
+     * @brief Show a relation constraint in the view of the navigator in which it has been selected
+     * @details The navigator is the one containing the focus widget or the widget under the mouse cursor.
+     *          A selection made outside of the navigators is attributed to the navigator only if there is a single one.
+     * @param relation The selected relation constraint
+     * @note This must be called from the main thread.
+     */
+    void bindRelationToSelectingView(FBConstraintRelation *relation);
+
+    /**
+     * @brief Attempt to install the event filter on the relation views of the registered navigators
+     * @details Schedules the next attempt with a doubled delay if no relation view is found.
+     */
+    void attemptFilterInstall();
+
 private:
     /**
      * @struct RelationViewState
@@ -160,13 +320,58 @@ private:
         double mLastScaleFactor = 1.0;                  //!<  Last scale factor of the relation view
     };
 
+    /**
+     * @struct RelationRenderProfile
+     * @brief Rolling render cost samples of the relation view for a relation constraint
+     */
+    struct RelationRenderProfile
+    {
+        static constexpr size_t maxSampleCount = 256; //!< Number of the latest frames kept for the percentiles
+
+        std::string relationName;                              //!< Name of the relation constraint at the time of the first sample
+        std::array<float, maxSampleCount> drawTimeMsSamples{}; //!< Ring buffer of the latest draw times in milliseconds
+        size_t nextSampleIndex = 0;                            //!< Index in drawTimeMsSamples to write the next sample
+        size_t sampleCount = 0;                                //!< Number of valid samples in drawTimeMsSamples
+        unsigned long long totalFrameCount = 0;                //!< Total number of frames recorded
+        RelationViewFrameStats lastFrameStats;                 //!< Draw statistics of the last recorded frame
+    };
+
+    static constexpr int filterInstallMaxAttemptCount = 8;    //!< Maximum number of attempts to install the event filter per request
+    static constexpr int filterInstallFirstRetryDelayMs = 25; //!< Delay before the first retry, doubled on each retry
+    static constexpr int loadPhaseCheckIntervalMs = 5000;     //!< Interval of the checks ending a load phase which receives no more events
+
     inline static RelationDialogManager *mInstance = nullptr; //!< Singleton instance pointer
-    std::atomic<bool> installRequired = false;                //!< Flag to indicate that installation of the event filter is required
     bool eventConnectionSetupFinished = false;                //!< Flag to ensure event connections are only set up once
+    std::atomic<bool> mIsShuttingDown = false;                //!< Flag to stop installing the event filter after onShutDown
+    std::atomic<bool> mIsLoadingFile = false;                 //!< Flag indicating the load phase, between file open/merge start and completion
+    std::atomic<unsigned long long> mSkippedEventCount = 0;   //!< Number of connection events skipped in the current load phase
+    unsigned long long mLoadPhaseGeneration = 0;              //!< Incremented on each load phase, to ignore the checks of the previous ones (main thread only)
+
+    bool mIsFilterInstallScheduled = false;               //!< Flag indicating that an install attempt is scheduled (main thread only)
+    int mFilterInstallAttemptCount = 0;                   //!< Number of failed install attempts for the current request (main thread only)
+    QMetaObject::Connection mRelationViewFoundConnection; //!< Connection to NavigatorRegistry::relationViewFound
+    QList<QPointer<QDockWidget>> mScannedNavigators;      //!< Navigators passed to setFilterInstallRequired for the next attempt (main thread only)
 
-    mutable std::mutex mRelationMutex;                                       //!< Mutex to protect access to mLastSelectedRelationConstraint
+    mutable std::mutex mRelationMutex;                                       //!< Mutex to serialize writers of mLastSelectedRelationConstraint, mRelationViewStates and mRelationViewSnapshot
     HdlFBPlugTemplate<FBConstraintRelation> mLastSelectedRelationConstraint; //!< Handle to the last selected relation constraint
 
+    /// Current snapshot of the relation view state, accessed with std::atomic_load/std::atomic_store
+    RelationViewSnapshotPtr mRelationViewSnapshot = std::make_shared<const RelationViewSnapshot>();
+
+    /// Map to store the relation constraint and the state shown by each relation view (main thread only, so no lock is taken)
+    std::unordered_map<const QOpenGLWidget *, RelationViewSnapshotPtr> mRelationViewSlots;
+
     /// Map to store the view state (position and scale) for each relation constraint
     std::unordered_map<FBConstraintRelation *, RelationViewState> mRelationViewStates;
+
+    /// Map to store the framebuffer of each relation view when its slot was last stored (main thread only)
+    std::unordered_map<const QOpenGLWidget *, GLint> mRelationViewFramebuffers;
+
+    mutable std::mutex mRenderProfileMutex; //!< Mutex to protect access to mRelationRenderProfiles and mFramebufferRelations
+
+    /// Map to store the render cost samples of the relation view for each relation constraint
+    std::unordered_map<FBConstraintRelation *, RelationRenderProfile> mRelationRenderProfiles;
+
+    /// Map to store the relation constraint shown by the relation view of each framebuffer, to attribute the frames rendered in it
+    std::unordered_map<GLint, HdlFBPlugTemplate<FBConstraintRelation>> mFramebufferRelations;
 };
\ No newline at end of file
@@ -0,0 +1,88 @@
+#include "BKTree.h"
+
+#include <algorithm>
+
+void BKTree::insert(const QString &word)
+{
+    if (word.isEmpty())
+        return;
+
+    if (mNodes.empty())
+    {
+        mNodes.push_back(Node{word, {}});
+        return;
+    }
+
+    int nodeIndex = 0;
+    while (true)
+    {
+        const int nodeDistance = distance(word, mNodes[nodeIndex].word);
+        if (nodeDistance == 0)
+            return;
+
+        auto &children = mNodes[nodeIndex].children;
+        auto childIt = std::find_if(children.begin(), children.end(), [nodeDistance](const std::pair<int, int> &child)
+                                    { return child.first == nodeDistance; });
+        if (childIt == children.end())
+        {
+            // Note: Push the child before the node, as push_back on mNodes might invalidate the children reference
+            children.emplace_back(nodeDistance, static_cast<int>(mNodes.size()));
+            mNodes.push_back(Node{word, {}});
+            return;
+        }
+
+        nodeIndex = childIt->second;
+    }
+}
+
+void BKTree::findWithin(const QString &word, int maxDistance, QHash<QString, int> &out) const
+{
+    if (mNodes.empty() || word.isEmpty())
+        return;
+
+    std::vector<int> pendingNodes{0};
+    while (!pendingNodes.empty())
+    {
+        const Node &node = mNodes[pendingNodes.back()];
+        pendingNodes.pop_back();
+
+        const int nodeDistance = distance(word, node.word);
+        if (nodeDistance <= maxDistance)
+        {
+            auto outIt = out.find(node.word);
+            if (outIt == out.end())
+                out.insert(node.word, nodeDistance);
+            else
+                outIt.value() = std::min(outIt.value(), nodeDistance);
+        }
+
+        // Only the children within maxDistance of nodeDistance can hold words within maxDistance of the word
+        for (const auto &child : node.children)
+        {
+            if (child.first >= nodeDistance - maxDistance && child.first <= nodeDistance + maxDistance)
+                pendingNodes.push_back(child.second);
+        }
+    }
+}
+
+int BKTree::distance(const QString &lhs, const QString &rhs)
+{
+    // Two rows of the dynamic programming table are enough
+    std::vector<int> previousRow(rhs.size() + 1);
+    std::vector<int> currentRow(rhs.size() + 1);
+    for (int j = 0; j <= rhs.size(); ++j)
+        previousRow[j] = j;
+
+    for (int i = 1; i <= lhs.size(); ++i)
+    {
+        currentRow[0] = i;
+        for (int j = 1; j <= rhs.size(); ++j)
+        {
+            const int substitutionCost = lhs[i - 1] == rhs[j - 1] ? 0 : 1;
+            currentRow[j] = std::min({previousRow[j] + 1, currentRow[j - 1] + 1, previousRow[j - 1] + substitutionCost});
+        }
+        std::swap(previousRow, currentRow);
+    }
+
+    return previousRow[rhs.size()];
+}
\ No newline at end of file
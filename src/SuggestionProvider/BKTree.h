@@ -0,0 +1,64 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include <QtCore/QHash>
+#include <QtCore/QString>
+
+/**
+ * @class BKTree
+ * @brief Burkhard-Keller tree of words for the typo-tolerant search
+ * @details Each child of a node is keyed by its Levenshtein distance to the node, so by the triangle inequality
+ *          a search within a distance d of a word only visits the children whose key is within d of the distance
+ *          between the word and the node. The words are expected to be case-folded by the caller.
+ */
+class BKTree
+{
+public:
+    /**
+     * @brief Remove all the words
+     */
+    void clear() { mNodes.clear(); }
+
+    /**
+     * @brief Check if the tree has no words
+     * @return true if the tree is empty, false otherwise
+     */
+    bool isEmpty() const { return mNodes.empty(); }
+
+    /**
+     * @brief Add a word to the tree
+     * @param word The word to add, ignored if empty or already added
+     */
+    void insert(const QString &word);
+
+    /**
+     * @brief Find the words within a distance of a word
+     * @param word The word to search for
+     * @param maxDistance The maximum Levenshtein distance of the words to find
+     * @param out Map to add the found words to with their distances, keeping the smaller distance of a word already in it
+     */
+    void findWithin(const QString &word, int maxDistance, QHash<QString, int> &out) const;
+
+    /**
+     * @brief Compute the Levenshtein distance between two words
+     * @param lhs The first word
+     * @param rhs The second word
+     * @return The minimum number of inserted, removed or replaced characters to turn one word into the other
+     */
+    static int distance(const QString &lhs, const QString &rhs);
+
+private:
+    /**
+     * @struct Node
+     * @brief A word of the tree with its children
+     */
+    struct Node
+    {
+        QString word;                              //!< Word of the node
+        std::vector<std::pair<int, int>> children; //!< Distance to the node and index in mNodes of each child
+    };
+
+    std::vector<Node> mNodes; //!< Nodes of the tree, the first one is the root
+};
\ No newline at end of file
@@ -0,0 +1,173 @@
+#include "MacroDependencyGraph.h"
+
+#include <algorithm>
+#include <utility>
+
+void MacroDependencyGraph::rebuild()
+{
+    // Clear the flag first, so changes notified while rebuilding mark the graph outdated again
+    mIsDirty = false;
+
+    // Number the relation constraints in the scene as nodes
+    std::vector<FBConstraintRelation *> relations;
+    mNodeIndices.clear();
+
+    FBScene *scene = FBSystem::TheOne().Scene;
+    for (int i = 0; i < scene->Constraints.GetCount(); ++i)
+    {
+        FBConstraint *constraint = scene->Constraints[i];
+        if (FBIS(constraint, FBConstraintRelation) == false)
+            continue;
+
+        FBConstraintRelation *relation = (FBConstraintRelation *)constraint;
+        if (mNodeIndices.emplace(relation, static_cast<int>(relations.size())).second)
+            relations.push_back(relation);
+    }
+
+    // Build the adjacency array, with an edge from each relation constraint to the macros added to it
+    const int nodeCount = static_cast<int>(relations.size());
+    mEdgeOffsets.assign(nodeCount + 1, 0);
+    mEdgeTargets.clear();
+
+    for (int node = 0; node < nodeCount; ++node)
+    {
+        FBConstraintRelation *relation = relations[node];
+        for (int i = 0; i < relation->GetSrcCount(); ++i)
+        {
+            FBPlug *srcPlug = relation->GetSrc(i);
+            if (FBIS(srcPlug, FBConstraintRelation) == false)
+                continue;
+
+            auto it = mNodeIndices.find((FBConstraintRelation *)srcPlug);
+            if (it != mNodeIndices.end())
+                mEdgeTargets.push_back(it->second);
+        }
+
+        mEdgeOffsets[node + 1] = static_cast<int>(mEdgeTargets.size());
+    }
+
+    computeComponents();
+    computeReachability();
+}
+
+bool MacroDependencyGraph::wouldCreateCycle(FBConstraintRelation *relation, FBConstraintRelation *macroCandidate) const
+{
+    // We cannot create a macro relation operator in itself
+    if (relation == macroCandidate)
+        return true;
+
+    auto relationIt = mNodeIndices.find(relation);
+    auto macroIt = mNodeIndices.find(macroCandidate);
+    if (relationIt == mNodeIndices.end() || macroIt == mNodeIndices.end())
+        return false;
+
+    // Adding the macro makes the relation constraint depend on it, so a cycle is created if the macro already depends on the relation constraint
+    const int relationComponent = mComponentOfNode[relationIt->second];
+    const int macroComponent = mComponentOfNode[macroIt->second];
+    const std::uint64_t word = mReachability[static_cast<size_t>(macroComponent) * mWordsPerComponent + relationComponent / 64];
+
+    return (word >> (relationComponent % 64)) & 1u;
+}
+
+void MacroDependencyGraph::computeComponents()
+{
+    constexpr int unvisited = -1;
+
+    const int nodeCount = static_cast<int>(mEdgeOffsets.size()) - 1;
+    mComponentOfNode.assign(nodeCount, unvisited);
+    mNodesInComponentOrder.clear();
+    mComponentCount = 0;
+
+    std::vector<int> discoveryIndices(nodeCount, unvisited);
+    std::vector<int> lowLinks(nodeCount, 0);
+    std::vector<bool> isOnStack(nodeCount, false);
+    std::vector<int> componentStack;
+
+    // Pairs of a node and the position of its next edge to visit, to avoid the recursion on deep macro chains
+    std::vector<std::pair<int, int>> callStack;
+    int nextDiscoveryIndex = 0;
+
+    auto visit = [&](int node)
+    {
+        discoveryIndices[node] = lowLinks[node] = nextDiscoveryIndex++;
+        componentStack.push_back(node);
+        isOnStack[node] = true;
+        callStack.emplace_back(node, mEdgeOffsets[node]);
+    };
+
+    for (int root = 0; root < nodeCount; ++root)
+    {
+        if (discoveryIndices[root] != unvisited)
+            continue;
+
+        visit(root);
+
+        while (!callStack.empty())
+        {
+            const int node = callStack.back().first;
+            int &edge = callStack.back().second;
+
+            if (edge < mEdgeOffsets[node + 1])
+            {
+                const int target = mEdgeTargets[edge++];
+
+                if (discoveryIndices[target] == unvisited)
+                    visit(target);
+                else if (isOnStack[target])
+                    lowLinks[node] = std::min(lowLinks[node], discoveryIndices[target]);
+
+                continue;
+            }
+
+            // All the edges of the node are visited
+            callStack.pop_back();
+
+            if (lowLinks[node] == discoveryIndices[node])
+            {
+                // The node is the root of a component, so pop its members
+                int member = unvisited;
+                do
+                {
+                    member = componentStack.back();
+                    componentStack.pop_back();
+                    isOnStack[member] = false;
+                    mComponentOfNode[member] = mComponentCount;
+                    mNodesInComponentOrder.push_back(member);
+                } while (member != node);
+
+                mComponentCount++;
+            }
+
+            if (!callStack.empty())
+            {
+                const int parent = callStack.back().first;
+                lowLinks[parent] = std::min(lowLinks[parent], lowLinks[node]);
+            }
+        }
+    }
+}
+
+void MacroDependencyGraph::computeReachability()
+{
+    mWordsPerComponent = (mComponentCount + 63) / 64;
+    mReachability.assign(static_cast<size_t>(mComponentCount) * mWordsPerComponent, 0);
+
+    // A component only depends on components with smaller numbers, whose bitsets are already complete
+    for (int node : mNodesInComponentOrder)
+    {
+        const int component = mComponentOfNode[node];
+        std::uint64_t *bitset = &mReachability[static_cast<size_t>(component) * mWordsPerComponent];
+        bitset[component / 64] |= std::uint64_t(1) << (component % 64);
+
+        for (int edge = mEdgeOffsets[node]; edge < mEdgeOffsets[node + 1]; ++edge)
+        {
+            const int targetComponent = mComponentOfNode[mEdgeTargets[edge]];
+            if (targetComponent == component)
+                continue;
+
+            const std::uint64_t *targetBitset = &mReachability[static_cast<size_t>(targetComponent) * mWordsPerComponent];
+            for (int word = 0; word < mWordsPerComponent; ++word)
+                bitset[word] |= targetBitset[word];
+        }
+    }
+}
\ No newline at end of file
@@ -0,0 +1,72 @@
+#pragma once
+
+#include <atomic>
+#include <cstdint>
+#include <unordered_map>
+#include <vector>
+
+#include <fbsdk/fbsdk.h>
+
+/**
+ * @class MacroDependencyGraph
+ * @brief Dependency graph of the relation constraints used as macros in each other
+ * @details A relation constraint depends on each relation constraint added to it as a macro box.
+ *          The graph is stored as a compact adjacency array, its strongly connected components are computed
+ *          with Tarjan's algorithm, and the reachability between the components is stored as bitsets.
+ *          So checking whether adding a macro would create a cycle takes constant time.
+ * @note The graph is rebuilt on the main thread when it is used after being marked dirty.
+ */
+class MacroDependencyGraph
+{
+public:
+    /**
+     * @brief Mark the graph as outdated, e.g. when a relation constraint or a macro box is added or removed
+     * @note This function can be called from any thread.
+     */
+    void markDirty() { mIsDirty = true; }
+
+    /**
+     * @brief Check if the graph must be rebuilt before use
+     * @return true if the graph is outdated, false otherwise
+     */
+    bool isDirty() const { return mIsDirty; }
+
+    /**
+     * @brief Rebuild the graph from the relation constraints in the scene
+     */
+    void rebuild();
+
+    /**
+     * @brief Check if adding a macro to a relation constraint would create a recursive loop
+     * @param relation The relation constraint to add the macro to
+     * @param macroCandidate The relation constraint to be added as a macro
+     * @return true if the macro already depends on the relation constraint, directly or indirectly, false otherwise
+     * @note The result reflects the scene when the graph was last rebuilt.
+     */
+    bool wouldCreateCycle(FBConstraintRelation *relation, FBConstraintRelation *macroCandidate) const;
+
+private:
+    /**
+     * @brief Compute the strongly connected components of the graph with an iterative Tarjan's algorithm
+     * @details The components are numbered in reverse topological order, that is, a component only depends on
+     *          components with smaller numbers.
+     */
+    void computeComponents();
+
+    /**
+     * @brief Compute the reachability bitsets of the components
+     */
+    void computeReachability();
+
+private:
+    std::atomic<bool> mIsDirty = true; //!< Flag indicating that the graph must be rebuilt
+
+    std::unordered_map<FBConstraintRelation *, int> mNodeIndices; //!< Node index of each relation constraint
+    std::vector<int> mEdgeOffsets;                                //!< Offset of the outgoing edges of each node in mEdgeTargets
+    std::vector<int> mEdgeTargets;                                //!< Target nodes of the edges, grouped by source node
+    std::vector<int> mComponentOfNode;                            //!< Strongly connected component of each node
+    std::vector<int> mNodesInComponentOrder;                      //!< Nodes sorted by their component
+    std::vector<std::uint64_t> mReachability;                     //!< Bitset of the components reachable from each component
+    int mComponentCount = 0;                                      //!< Number of strongly connected components
+    int mWordsPerComponent = 0;                                   //!< Number of 64-bit words in the bitset of a component
+};
\ No newline at end of file
@@ -0,0 +1,395 @@
+#include "ModelQuery.h"
+
+#include <algorithm>
+
+#include <QtCore/QtAlgorithms>
+
+/**
+ * @struct ModelTypeKeyword
+ * @brief Keyword of a model type in the "t:" query terms
+ */
+struct ModelTypeKeyword
+{
+    const char *keyword;      //!< Keyword in lower case
+    ModelSearchFilter filter; //!< Search filter of the type
+};
+
+static const ModelTypeKeyword modelTypeKeywords[] = {
+    {"model", ModelSearchFilter::FBModelObjects},
+    {"camera", ModelSearchFilter::Cameras},
+    {"cameraswitcher", ModelSearchFilter::CameraSwitchers},
+    {"cube", ModelSearchFilter::Cubes},
+    {"light", ModelSearchFilter::Lights},
+    {"marker", ModelSearchFilter::Markers},
+    {"null", ModelSearchFilter::Nulls},
+    {"optical", ModelSearchFilter::Opticals},
+    {"path3d", ModelSearchFilter::Path3Ds},
+    {"plane", ModelSearchFilter::Planes},
+    {"root", ModelSearchFilter::Roots},
+    {"skeleton", ModelSearchFilter::Skeletons},
+};
+
+/**
+ * @brief Extract the literal runs which every name matching a glob contains
+ * @param pattern The glob pattern
+ * @return The literal runs between the wildcards and the character sets
+ */
+static QStringList extractGlobLiterals(const QString &pattern)
+{
+    QStringList literals;
+    QString run;
+    for (int i = 0; i < pattern.size(); ++i)
+    {
+        const QChar c = pattern[i];
+        if (c == QLatin1Char('*') || c == QLatin1Char('?') || c == QLatin1Char('['))
+        {
+            literals.push_back(run);
+            run.clear();
+
+            // Skip the character set, whose first character may be a closing bracket, e.g. "[]a]"
+            if (c == QLatin1Char('['))
+            {
+                int setEnd = i + 1;
+                if (setEnd < pattern.size() && pattern[setEnd] == QLatin1Char('!'))
+                    ++setEnd;
+                if (setEnd < pattern.size() && pattern[setEnd] == QLatin1Char(']'))
+                    ++setEnd;
+                while (setEnd < pattern.size() && pattern[setEnd] != QLatin1Char(']'))
+                    ++setEnd;
+                i = setEnd;
+            }
+            continue;
+        }
+        run += c;
+    }
+    literals.push_back(run);
+    return literals;
+}
+
+/**
+ * @brief Extract literal runs which every name matching a regular expression contains
+ * @details The extraction is conservative: patterns with alternations yield no literals, groups and escapes break the runs,
+ *          and a character followed by an optional quantifier is dropped from its run.
+ * @param pattern The regular expression pattern
+ * @return The literal runs outside of the groups, character classes and quantified characters
+ */
+static QStringList extractRegexLiterals(const QString &pattern)
+{
+    QStringList literals;
+    if (pattern.contains(QLatin1Char('|')))
+        return literals;
+
+    QString run;
+    int groupDepth = 0;
+    auto flushRun = [&literals, &run]()
+    {
+        literals.push_back(run);
+        run.clear();
+    };
+
+    for (int i = 0; i < pattern.size(); ++i)
+    {
+        const QChar c = pattern[i];
+        switch (c.unicode())
+        {
+        case '\\':
+            // Escapes such as "\d" are not literals, and an escaped character might be quantified
+            flushRun();
+            ++i;
+            break;
+        case '[':
+        {
+            flushRun();
+            int classEnd = i + 1;
+            if (classEnd < pattern.size() && pattern[classEnd] == QLatin1Char('^'))
+                ++classEnd;
+            if (classEnd < pattern.size() && pattern[classEnd] == QLatin1Char(']'))
+                ++classEnd;
+            while (classEnd < pattern.size() && pattern[classEnd] != QLatin1Char(']'))
+                classEnd += pattern[classEnd] == QLatin1Char('\\') ? 2 : 1;
+            i = classEnd;
+            break;
+        }
+        case '(':
+            flushRun();
+            ++groupDepth;
+            break;
+        case ')':
+            flushRun();
+            groupDepth = std::max(groupDepth - 1, 0);
+            break;
+        case '?':
+        case '*':
+        case '{':
+            // The quantified character may be absent
+            run.chop(1);
+            flushRun();
+            if (c == QLatin1Char('{'))
+            {
+                while (i < pattern.size() && pattern[i] != QLatin1Char('}'))
+                    ++i;
+            }
+            break;
+        case '+':
+        case '.':
+        case '^':
+        case '$':
+            flushRun();
+            break;
+        default:
+            if (groupDepth == 0)
+                run += c;
+            break;
+        }
+    }
+    flushRun();
+    return literals;
+}
+
+/// Index of the first bit shared by several characters in the character masks
+constexpr int firstSharedCharacterMaskBit = 36;
+
+/**
+ * @brief Get the bit of a character in the character masks
+ * @param c The character
+ * @return The index of the bit, from 0 to 63
+ */
+static int characterMaskBit(QChar c)
+{
+    const int folded = c.toCaseFolded().unicode();
+    if (folded >= 'a' && folded <= 'z')
+        return folded - 'a';
+    if (folded >= '0' && folded <= '9')
+        return 26 + folded - '0';
+
+    // Separators and other characters share the remaining 28 bits
+    return firstSharedCharacterMaskBit + folded % 28;
+}
+
+quint64 computeCharacterMask(const QString &text)
+{
+    quint64 characterMask = 0;
+    for (const QChar c : text)
+        characterMask |= quint64(1) << characterMaskBit(c);
+    return characterMask;
+}
+
+void appendCharacterPositions(const QString &name, quint64 characterMask, std::vector<quint64> &positionMasks)
+{
+    const size_t firstMask = positionMasks.size();
+    positionMasks.resize(firstMask + qPopulationCount(characterMask), 0);
+
+    const int length = std::min(static_cast<int>(name.size()), tokenStartMaskLength);
+    for (int i = 0; i < length; ++i)
+    {
+        const quint64 bit = quint64(1) << characterMaskBit(name[i]);
+        if ((characterMask & bit) == 0)
+            continue;
+
+        // The masks are stored for the set bits only, so the index of a bit is the number of set bits below it
+        positionMasks[firstMask + qPopulationCount(characterMask & (bit - 1))] |= quint64(1) << i;
+    }
+}
+
+quint64 CharacterPositions::find(QChar foldedCharacter) const
+{
+    const int bitIndex = characterMaskBit(foldedCharacter);
+    const quint64 bit = quint64(1) << bitIndex;
+    if ((characterMask & bit) == 0)
+        return 0;
+
+    quint64 positions = positionMasks[qPopulationCount(characterMask & (bit - 1))];
+
+    // Letters and digits have their own bits, but the other characters share theirs, so compare them
+    if (bitIndex >= firstSharedCharacterMaskBit)
+    {
+        for (quint64 remaining = positions; remaining != 0; remaining &= remaining - 1)
+        {
+            const int i = qCountTrailingZeroBits(remaining);
+            if (name[i].toCaseFolded() != foldedCharacter)
+                positions &= ~(quint64(1) << i);
+        }
+    }
+    return positions;
+}
+
+quint64 computeTokenStartMask(const QString &name)
+{
+    quint64 tokenStarts = 0;
+    const int length = std::min(static_cast<int>(name.size()), tokenStartMaskLength);
+    for (int i = 0; i < length; ++i)
+    {
+        const QChar c = name[i];
+        if (!c.isLetterOrNumber())
+            continue;
+
+        bool isTokenStart = true;
+        if (i > 0 && name[i - 1].isLetterOrNumber())
+        {
+            const QChar previous = name[i - 1];
+            const bool isNextLower = i + 1 < name.size() && name[i + 1].isLower();
+
+            // A case change, such as "tH" in "LeftHand" or "KH" in "IKHand", or a boundary between letters and digits
+            isTokenStart = (c.isUpper() && (previous.isLower() || (previous.isUpper() && isNextLower))) ||
+                           c.isDigit() != previous.isDigit();
+        }
+
+        if (isTokenStart)
+            tokenStarts |= quint64(1) << i;
+    }
+    return tokenStarts;
+}
+
+bool ModelQueryPattern::matches(const QString &target) const
+{
+    return containsRequiredLiterals(target) && regex.match(target).hasMatch();
+}
+
+bool ModelQueryPattern::containsRequiredLiterals(const QString &target) const
+{
+    for (const QString &literal : requiredLiterals)
+    {
+        if (!target.contains(literal, Qt::CaseInsensitive))
+            return false;
+    }
+    return true;
+}
+
+bool ModelQueryPattern::mightContainRequiredLiterals(const QString &nameSpace, const QString &name) const
+{
+    for (const QString &literal : requiredLiterals)
+    {
+        if (literal.contains(QLatin1Char(':')))
+            continue;
+
+        if (!name.contains(literal, Qt::CaseInsensitive) && !nameSpace.contains(literal, Qt::CaseInsensitive))
+            return false;
+    }
+    return true;
+}
+
+ModelQueryPattern compileModelQueryPattern(const QString &pattern, bool isGlob)
+{
+    ModelQueryPattern compiled;
+    compiled.regex.setPattern(isGlob ? QRegularExpression::wildcardToRegularExpression(pattern) : pattern);
+    compiled.regex.setPatternOptions(QRegularExpression::CaseInsensitiveOption);
+    if (!compiled.regex.isValid())
+        return compiled;
+
+    compiled.regex.optimize();
+
+    // Keep the longest literals first, as they reject the most names
+    const QStringList literals = isGlob ? extractGlobLiterals(pattern) : extractRegexLiterals(pattern);
+    for (const QString &literal : literals)
+    {
+        if (!literal.isEmpty())
+            compiled.requiredLiterals.push_back(literal);
+    }
+    std::stable_sort(compiled.requiredLiterals.begin(), compiled.requiredLiterals.end(),
+                     [](const QString &a, const QString &b)
+                     { return a.size() > b.size(); });
+
+    return compiled;
+}
+
+ModelQueryTerm::TokenMatch ModelQueryTerm::matchTokens(const CharacterPositions &positions, quint64 tokenStarts, int nameStart) const
+{
+    if (foldedText.isEmpty() || nameStart >= tokenStartMaskLength)
+        return TokenMatch::None;
+
+    const quint64 startableMask = ~((quint64(1) << nameStart) - 1);
+
+    // Bitmasks of the positions where the text matched so far can end,
+    // contiguously from a token start, or jumping to later token starts
+    quint64 contiguousEnds = 0;
+    quint64 acronymEnds = 0;
+
+    for (int j = 0; j < foldedText.size(); ++j)
+    {
+        const quint64 equalMask = positions.find(foldedText[j]);
+
+        if (j == 0)
+        {
+            contiguousEnds = equalMask & tokenStarts & startableMask;
+            acronymEnds = contiguousEnds;
+        }
+        else
+        {
+            // Token starts after the earliest end, where the next token of the acronym can start
+            const quint64 earliestEnd = acronymEnds & (~acronymEnds + 1);
+            const quint64 laterTokenStarts = tokenStarts & ~((earliestEnd << 1) - 1);
+
+            contiguousEnds = equalMask & (contiguousEnds << 1);
+            acronymEnds = equalMask & ((acronymEnds << 1) | laterTokenStarts);
+        }
+
+        if (acronymEnds == 0)
+            return TokenMatch::None;
+    }
+
+    return contiguousEnds != 0 ? TokenMatch::TokenStart : TokenMatch::Acronym;
+}
+
+bool ModelQueryTerm::matches(const QString &nameSpace, const QString &name) const
+{
+    if (kind != Kind::Text)
+    {
+        if (isNameOnly || nameSpace.isEmpty())
+            return pattern.matches(name);
+
+        // The long name contains the name, so the name cannot contain a literal missing from the long name
+        if (!pattern.mightContainRequiredLiterals(nameSpace, name))
+            return false;
+
+        if (pattern.matches(name))
+            return true;
+
+        const QString longName = nameSpace + QLatin1Char(':') + name;
+        return pattern.containsRequiredLiterals(longName) && pattern.regex.match(longName).hasMatch();
+    }
+
+    auto matchesTarget = [this](const QString &target)
+    {
+        if (isAnchoredStart && isAnchoredEnd)
+            return target.compare(text, Qt::CaseInsensitive) == 0;
+        if (isAnchoredStart)
+            return target.startsWith(text, Qt::CaseInsensitive);
+        if (isAnchoredEnd)
+            return target.endsWith(text, Qt::CaseInsensitive);
+
+        return target.contains(text, Qt::CaseInsensitive);
+    };
+
+    if (isNameOnly || nameSpace.isEmpty())
+        return matchesTarget(name);
+
+    // Without the separator, the text can only be found within the namespace or the name,
+    // and the long name only starts with the namespace and ends with the name
+    if (!text.contains(QLatin1Char(':')))
+        return matchesTarget(name) || (!isAnchoredEnd && matchesTarget(nameSpace));
+
+    return matchesTarget(name) || matchesTarget(nameSpace + QLatin1Char(':') + name);
+}
+
+ModelSearchFilters modelSearchFiltersForKeyword(const QString &keyword)
+{
+    const QString lowerKeyword = keyword.toLower();
+
+    // Exact match in the singular or the plural form
+    for (const ModelTypeKeyword &typeKeyword : modelTypeKeywords)
+    {
+        const QLatin1String typeName(typeKeyword.keyword);
+        if (lowerKeyword == typeName || (lowerKeyword.endsWith(QLatin1Char('s')) && lowerKeyword.chopped(1) == typeName))
+            return typeKeyword.filter;
+    }
+
+    // Prefix match, e.g. while the keyword is being typed
+    ModelSearchFilters filters = ModelSearchFilter::None;
+    for (const ModelTypeKeyword &typeKeyword : modelTypeKeywords)
+    {
+        if (QLatin1String(typeKeyword.keyword).startsWith(lowerKeyword))
+            filters |= typeKeyword.filter;
+    }
+
+    return filters;
+}
\ No newline at end of file
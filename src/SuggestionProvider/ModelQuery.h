@@ -0,0 +1,232 @@
+#pragma once
+
+#include <utility>
+#include <vector>
+
+#include <QtCore/QList>
+#include <QtCore/QRegularExpression>
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+#include <QtCore/QStringView>
+#include <QtCore/QVector>
+
+#include "RelationDialogConfig.h"
+
+/// Number of leading characters of a name covered by its token-start bitmask
+constexpr int tokenStartMaskLength = 64;
+
+/**
+ * @brief Compute the token starts of a name for the token matching of the query terms
+ * @details Tokens start after separators such as "_" and ":", at case changes ("LeftHand", "IKHand")
+ *          and at the boundaries between letters and digits ("Index01"), so "LeftHandIndex1", "L_Hand_Index_01"
+ *          and "lHandIdx1" are all split into a side, a hand and a finger token.
+ * @param name The name to tokenize
+ * @return Bitmask whose bit i is set if the character i starts a token, covering the first tokenStartMaskLength characters
+ */
+quint64 computeTokenStartMask(const QString &name);
+
+/**
+ * @brief Compute the presence mask of the case-folded characters of a text
+ * @details Letters and digits have their own bits and the other characters share the remaining bits,
+ *          so a name whose mask is not a superset of the mask of a text cannot contain the text,
+ *          nor match it as an acronym, and is rejected with one AND-compare.
+ * @param text The text to compute the mask of
+ * @return Bitmask of the characters present in the text
+ */
+quint64 computeCharacterMask(const QString &text);
+
+/**
+ * @brief Append the positions of the case-folded characters of a name, for the token matching of the query terms
+ * @details One position bitmask is appended for each bit set in the character mask, in bit order,
+ *          so the positions of a query character are looked up instead of scanning the name for each query.
+ * @param name The name, which does not need to be case-folded
+ * @param characterMask The character mask of the name, which must include computeCharacterMask(name)
+ * @param positionMasks The array to append the position bitmasks to
+ */
+void appendCharacterPositions(const QString &name, quint64 characterMask, std::vector<quint64> &positionMasks);
+
+/**
+ * @struct CharacterPositions
+ * @brief Positions of the case-folded characters of a name, appended by appendCharacterPositions()
+ */
+struct CharacterPositions
+{
+    QStringView name;                       //!< Name passed to appendCharacterPositions()
+    quint64 characterMask = 0;              //!< Character mask passed to appendCharacterPositions()
+    const quint64 *positionMasks = nullptr; //!< First position bitmask appended by appendCharacterPositions()
+
+    /**
+     * @brief Get the positions of a character in the name
+     * @param foldedCharacter The case-folded character
+     * @return Bitmask whose bit i is set if the character i equals the character ignoring case, covering the first tokenStartMaskLength characters
+     */
+    quint64 find(QChar foldedCharacter) const;
+};
+
+/**
+ * @enum ModelMatchRank
+ * @brief How well a model matches a query, the model suggestions are listed by rank and then by name
+ */
+enum class ModelMatchRank
+{
+    TokenStart, //!< All the text terms are found at the start of a token, e.g. "hand" in "LeftHandIndex1"
+    Substring,  //!< All the text terms are found, some of them in the middle of a token
+    Acronym,    //!< Some text terms only match the prefixes of successive tokens, e.g. "lhi" in "LeftHandIndex1"
+    None        //!< The model does not match
+};
+
+/**
+ * @struct ModelQueryPattern
+ * @brief Compiled glob or regular expression of a query term
+ * @details Compiling a pattern is much more expensive than matching it, so the compiled patterns are cached
+ *          by SuggestionProvider and shared by the queries compiled on each keystroke.
+ */
+struct ModelQueryPattern
+{
+    QRegularExpression regex;     //!< Compiled case-insensitive pattern
+    QStringList requiredLiterals; //!< Substrings which every matching name contains, longest first
+
+    /**
+     * @brief Check if a name matches the pattern, ignoring case
+     * @details The required literals are checked first, so most names are rejected without running the regex engine.
+     * @param target The name to match
+     * @return true if the name matches the pattern, false otherwise
+     */
+    bool matches(const QString &target) const;
+
+    /**
+     * @brief Check if a name contains all the required literals, ignoring case
+     * @param target The name to check
+     * @return true if the name contains all the required literals, false otherwise
+     */
+    bool containsRequiredLiterals(const QString &target) const;
+
+    /**
+     * @brief Check if the long name of a model might contain all the required literals, ignoring case
+     * @details A literal without ":" is contained in the long name only if the namespace or the name contains it,
+     *          so most models are rejected without building their long names. The literals with ":" are left to the regex.
+     * @param nameSpace The namespace of the model
+     * @param name The name of the model
+     * @return false if the long name cannot contain all the required literals, true otherwise
+     */
+    bool mightContainRequiredLiterals(const QString &nameSpace, const QString &name) const;
+};
+
+/**
+ * @brief Compile a glob or a regular expression of a query term
+ * @details A glob supports "*", "?" and "[...]" and matches the whole name, e.g. "*_L_*" or "finger[0-4]".
+ *          A regular expression matches any part of the name unless it is anchored.
+ * @param pattern The pattern text, without the operators of the term
+ * @param isGlob true if the pattern is a glob, false if it is a regular expression
+ * @return The compiled pattern, whose regex is invalid if the pattern has a syntax error
+ */
+ModelQueryPattern compileModelQueryPattern(const QString &pattern, bool isGlob);
+
+/**
+ * @struct ModelQueryTerm
+ * @brief A text term of a compiled model query
+ */
+struct ModelQueryTerm
+{
+    /**
+     * @enum Kind
+     * @brief How the term is matched against the names
+     */
+    enum class Kind
+    {
+        Text,  //!< The text is contained in the name, or anchored to it
+        Glob,  //!< The glob pattern matches the whole name
+        Regex, //!< The regular expression matches a part of the name
+    };
+
+    Kind kind = Kind::Text;       //!< How the term is matched
+    QString text;                 //!< Text to match, without the operators
+    ModelQueryPattern pattern;    //!< Compiled pattern of a glob or regex term
+    bool isExcluded = false;      //!< Flag indicating that the model must not match the term, written as "-term"
+    bool isAnchoredStart = false; //!< Flag indicating that the name must start with the text, written as "^term"
+    bool isAnchoredEnd = false;   //!< Flag indicating that the name must end with the text, written as "term$"
+    bool isNameOnly = false;      //!< Flag indicating that the term is matched against the model name only
+    QString foldedText;           //!< Case-folded text, to match the names at their token starts ignoring case
+
+    /**
+     * @enum TokenMatch
+     * @brief How the text of a term matches the tokens of a name
+     */
+    enum class TokenMatch
+    {
+        None,       //!< The text does not match the tokens
+        Acronym,    //!< The characters of the text match the prefixes of successive tokens
+        TokenStart, //!< The text is found at the start of a token
+    };
+
+    /**
+     * @brief Check if the term can match the tokens of a name
+     * @return true for the unanchored text terms which are not excluded, false otherwise
+     */
+    bool isTokenMatchable() const { return kind == Kind::Text && !isExcluded && !isAnchoredStart && !isAnchoredEnd; }
+
+    /**
+     * @brief Match the text against the tokens of a name with bitmask tests, ignoring case
+     * @details Each character of the text either continues the token being matched or starts a later token,
+     *          so "lhi" and "lhandidx" both match "LeftHandIndex1", while "hand" is found at a token start.
+     * @param positions The positions of the characters of the name
+     * @param tokenStarts The computeTokenStartMask() value of the name
+     * @param nameStart The index of the first character which can start a match, to skip the namespace of name-only terms
+     * @return How the text matches the tokens
+     */
+    TokenMatch matchTokens(const CharacterPositions &positions, quint64 tokenStarts, int nameStart) const;
+
+    /**
+     * @brief Check if a model matches the term, ignoring case and the isExcluded flag
+     * @details Anchored and pattern terms match if either the model name or the long name satisfies them,
+     *          so "^hand" matches "Actor01:hand" and "^Actor01" matches it too.
+     *          The long name "Namespace:Name" is only built for the terms which can match across the separator.
+     * @param nameSpace The namespace of the model, empty if none
+     * @param name The name of the model
+     * @return true if the model matches the text with the anchors, false otherwise
+     */
+    bool matches(const QString &nameSpace, const QString &name) const;
+};
+
+/**
+ * @struct ModelQuery
+ * @brief Model query compiled from the search box text, evaluated for each model entry without allocation
+ * @details The query syntax is a list of space-separated terms, all of which must match:
+ *          - "t:camera" restricts the model types, multiple type terms are combined with OR
+ *          - "ns:Actor01" restricts the namespaces, multiple namespace terms are combined with OR
+ *          - "Actor01:hand" restricts the namespace and matches the rest against the model names
+ *          - "^term" and "term$" anchor the text to the start and the end of the name
+ *          - A term containing "*", "?" or "[" is a glob matching the whole name, such as "*_L_*" or "finger[0-4]"
+ *          - "/regex/" is a regular expression, the closing slash is optional
+ *          - "-term" excludes the models matching the term
+ *          - Any other term is contained in the name, ignoring case, or matches its tokens as an acronym such as "lhi"
+ * @note The namespace ids and ranges refer to the model entries of the revision the query was compiled for.
+ */
+struct ModelQuery
+{
+    QString text;                                             //!< Trimmed text of the query, used for the exact match
+    ModelSearchFilters typeFilters = ModelSearchFilter::None; //!< Model types to include
+    QVector<bool> namespaceMask;                              //!< Flags indexed by namespace id, empty if the namespaces are not restricted
+    QVector<std::pair<int, int>> entryRanges;                 //!< Ranges [begin, end) of the model entries to scan, in order, one per included namespace
+    QList<ModelQueryTerm> terms;                              //!< Text terms in the order they are written
+    int exactMatchIndex = -1;                                 //!< Index of the model entry whose long name equals the text, -1 if none
+    bool isUnsatisfiable = false;                             //!< Flag indicating that no model can match, e.g. an unknown type
+    bool isRanked = false;                                    //!< Flag indicating that some terms can match the tokens, so the matches are listed by rank
+    quint64 characterMask = 0;                                //!< Characters which every matching long name contains, see computeCharacterMask()
+
+    /**
+     * @brief Check if a namespace is included in the query
+     * @param namespaceId The id of the namespace
+     * @return true if the namespaces are not restricted or the namespace is included, false otherwise
+     */
+    bool includesNamespace(int namespaceId) const { return namespaceMask.isEmpty() || namespaceMask[namespaceId]; }
+};
+
+/**
+ * @brief Resolve the keyword of a "t:" query term to model search filters
+ * @details A keyword matches a type exactly, in the singular or the plural form, e.g. "camera" or "cameras".
+ *          Otherwise it matches all the types which start with the keyword, e.g. "cam" matches cameras and camera switchers.
+ * @param keyword The keyword after "t:", ignoring case
+ * @return The matching search filters, ModelSearchFilter::None if no type matches
+ */
+ModelSearchFilters modelSearchFiltersForKeyword(const QString &keyword);
\ No newline at end of file
@@ -1,10 +1,18 @@
 #include "SuggestionProvider.h"
 
+#include <algorithm>
+#include <numeric>
 #include <string>
+#include <utility>
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QtAlgorithms>
+#include <QtCore/QMetaObject>
 
 #include <fbsdk/fbsdk.h>
 
 #include "RelationDialogManager.h"
+#include "Utility.h"
 
 static ModelSearchFilter modelSearchFilterForTypeId(int typeId)
 {
@@ -36,14 +44,54 @@ static ModelSearchFilter modelSearchFilterForTypeId(int typeId)
     return ModelSearchFilter::None;
 }
 
-QStringList SuggestionProvider::getOperatorSuggestions(QStringView queryView) const
+/**
+ * @brief Split a text into case-folded words of letters and digits
+ * @param text The text to split, e.g. "Multiply (a x b)"
+ * @return The words of the text, e.g. "multiply", "a", "x" and "b"
+ */
+static QStringList splitOperatorWords(const QString &text)
+{
+    QStringList words;
+    QString word;
+    for (const QChar c : text)
+    {
+        if (c.isLetterOrNumber())
+            word += c.toCaseFolded();
+        else if (!word.isEmpty())
+        {
+            words.push_back(word);
+            word.clear();
+        }
+    }
+    if (!word.isEmpty())
+        words.push_back(word);
+
+    return words;
+}
+
+/**
+ * @brief Add the words of an operator entry to a word tree
+ * @param tree The tree to add the words to
+ * @param words The words of the entry, split by splitOperatorWords()
+ */
+static void addOperatorWords(BKTree &tree, const QStringList &words)
+{
+    for (const QString &word : words)
+        tree.insert(word);
+}
+
+QStringList SuggestionProvider::getOperatorSuggestions(QStringView queryView, FBConstraintRelation *relation) const
 {
     const QString query = queryView.toString().trimmed();
 
     // Combine default operators and macros into a single list of entries
     QList<OperatorEntry> operatorEntries;
     operatorEntries.append(mDefaultOperatorEntriesBeforeMacro);
-    collectMyMacrosEntry(operatorEntries);
+    const bool isMacroCatalogUsed = isMacroCatalogReady(relation);
+    if (isMacroCatalogUsed)
+        operatorEntries.append(mMacroEntries);
+    else
+        collectMyMacrosEntry(relation, operatorEntries);
     operatorEntries.append(mDefaultOperatorEntriesAfterMacro);
 
     QStringList out;
@@ -60,9 +108,14 @@ QStringList SuggestionProvider::getOperatorSuggestions(QStringView queryView) co
     }
 
     QList<const OperatorEntry *> entryCategoryStarts, entryCategoryContains, entryOperatorStarts, entryOperatorContains;
+    const quint64 queryCharacterMask = computeCharacterMask(query);
 
     for (const auto &entry : operatorEntries)
     {
+        // Entries missing any character of the query cannot contain it
+        if ((entry.characterMask & queryCharacterMask) != queryCharacterMask)
+            continue;
+
         const bool categoryStarts = entry.categoryName.startsWith(query, Qt::CaseInsensitive);
         const bool categoryContains = !categoryStarts && entry.categoryName.contains(query, Qt::CaseInsensitive);
         const bool operatorStarts = entry.operatorName.startsWith(query, Qt::CaseInsensitive);
@@ -92,7 +145,26 @@ QStringList SuggestionProvider::getOperatorSuggestions(QStringView queryView) co
         }
     }
 
-    for (const auto &entry : entryCategoryStarts + entryCategoryContains + entryOperatorStarts + entryOperatorContains)
+    QList<const OperatorEntry *> matchedEntries = entryCategoryStarts + entryCategoryContains + entryOperatorStarts + entryOperatorContains;
+
+    // Fall back to the typo-tolerant search when no entry contains the query, e.g. "Multipy" or "Vecotr"
+    if (matchedEntries.isEmpty())
+    {
+        // The macros collected for this call only are few, so their words are indexed on the fly
+        BKTree collectedMacroWordTree;
+        if (!isMacroCatalogUsed)
+        {
+            for (const auto &entry : operatorEntries)
+            {
+                if (entry.categoryName == QLatin1String("My Macros"))
+                    addOperatorWords(collectedMacroWordTree, entry.words);
+            }
+        }
+
+        matchedEntries = findOperatorEntriesWithTypos(query, operatorEntries, isMacroCatalogUsed ? mMacroWordTree : collectedMacroWordTree);
+    }
+
+    for (const auto &entry : matchedEntries)
     {
         addOperatorSuggestion(out, *entry);
     }
@@ -100,47 +172,323 @@ QStringList SuggestionProvider::getOperatorSuggestions(QStringView queryView) co
     return out;
 }
 
-QStringList SuggestionProvider::getModelSuggestions(QStringView queryView) const
+ModelQuery SuggestionProvider::compileModelQuery(QStringView queryView) const
 {
-    const QString query = queryView.toString().trimmed();
+    ModelQuery query;
+    query.text = queryView.toString().trimmed();
+    query.typeFilters = mModelSearchFilters;
 
-    QStringList out;
+    ModelSearchFilters requestedTypeFilters = ModelSearchFilter::None;
+    bool hasTypeTerm = false;
+    QVector<bool> requestedNamespaceMask;
+    bool hasNamespaceTerm = false;
 
-    for (const auto &entry : mModelEntries)
+    // Intersect the namespace restriction of the query with another one
+    auto restrictNamespaces = [&query](const QVector<bool> &namespaceMask)
     {
-        // Create long name list for display and filtering
-        const QString longName = entry.nameSpace.isEmpty() ? entry.name : entry.nameSpace + ":" + entry.name;
-        FBTrace("Checking model entry '%s' with long name '%s' against query '%s'\n", entry.name.toUtf8().constData(), longName.toUtf8().constData(), query.toUtf8().constData());
+        if (query.namespaceMask.isEmpty())
+        {
+            query.namespaceMask = namespaceMask;
+            return;
+        }
+
+        for (int i = 0; i < query.namespaceMask.size(); ++i)
+            query.namespaceMask[i] = query.namespaceMask[i] && namespaceMask[i];
+    };
 
-        // First we check if the query is contained in the name
-        // Note: if the query is empty, all entries will be included
-        if (!query.isEmpty())
+    // Parse the space-separated tokens
+    const QString &text = query.text;
+    int tokenStart = 0;
+    while (tokenStart < text.size())
+    {
+        if (text[tokenStart].isSpace())
         {
-            if (mIsModelNamespaceSearchDisabled)
+            ++tokenStart;
+            continue;
+        }
+
+        int tokenEnd = tokenStart;
+        while (tokenEnd < text.size() && !text[tokenEnd].isSpace())
+            ++tokenEnd;
+
+        const QString token = text.mid(tokenStart, tokenEnd - tokenStart);
+        tokenStart = tokenEnd;
+
+        // Type term, such as "t:camera"
+        // Note: Terms without a value are ignored, as they are likely being typed
+        if (token.startsWith(QLatin1String("t:"), Qt::CaseInsensitive))
+        {
+            if (token.size() > 2)
             {
-                if (!entry.name.contains(query, Qt::CaseInsensitive))
-                    continue;
+                requestedTypeFilters |= modelSearchFiltersForKeyword(token.mid(2));
+                hasTypeTerm = true;
             }
-            else
+            continue;
+        }
+
+        // Namespace term, such as "ns:Actor01"
+        if (token.startsWith(QLatin1String("ns:"), Qt::CaseInsensitive))
+        {
+            if (token.size() > 3)
+            {
+                const QVector<bool> namespaceMask = namespaceMaskForName(token.mid(3));
+                if (!hasNamespaceTerm)
+                    requestedNamespaceMask = namespaceMask;
+                else
+                {
+                    for (int i = 0; i < requestedNamespaceMask.size(); ++i)
+                        requestedNamespaceMask[i] = requestedNamespaceMask[i] || namespaceMask[i];
+                }
+                hasNamespaceTerm = true;
+            }
+            continue;
+        }
+
+        // Text term, with the exclusion and the anchors
+        ModelQueryTerm term;
+        term.text = token;
+        term.isNameOnly = mIsModelNamespaceSearchDisabled;
+
+        if (term.text.startsWith(QLatin1Char('-')))
+        {
+            term.isExcluded = true;
+            term.text.remove(0, 1);
+        }
+
+        // Regular expression term, such as "/finger[0-4]$/"
+        // Note: Patterns with a syntax error are ignored, as they are likely being typed
+        if (term.text.startsWith(QLatin1Char('/')))
+        {
+            term.text.remove(0, 1);
+            if (term.text.endsWith(QLatin1Char('/')))
+                term.text.chop(1);
+            if (term.text.isEmpty())
+                continue;
+
+            term.pattern = getModelQueryPattern(term.text, false);
+            if (term.pattern.regex.isValid())
+            {
+                term.kind = ModelQueryTerm::Kind::Regex;
+                if (!term.isExcluded)
+                {
+                    for (const QString &literal : term.pattern.requiredLiterals)
+                        query.characterMask |= computeCharacterMask(literal);
+                }
+                query.terms.push_back(term);
+            }
+            continue;
+        }
+
+        if (term.text.startsWith(QLatin1Char('^')))
+        {
+            term.isAnchoredStart = true;
+            term.text.remove(0, 1);
+        }
+        if (term.text.endsWith(QLatin1Char('$')))
+        {
+            term.isAnchoredEnd = true;
+            term.text.chop(1);
+        }
+
+        // A scoped term such as "Actor03:hand" restricts the namespace and matches the rest against the model names
+        const int separatorIndex = term.text.lastIndexOf(QLatin1Char(':'));
+        if (!term.isExcluded && separatorIndex > 0)
+        {
+            const QString namespaceSortKey = term.text.left(separatorIndex).toCaseFolded();
+            if (mNamespaceRanges.contains(namespaceSortKey))
             {
-                if (!longName.contains(query, Qt::CaseInsensitive))
-                    continue;
+                QVector<bool> namespaceMask(mNamespaces.size(), false);
+                for (int namespaceId = 1; namespaceId < mNamespaces.size(); ++namespaceId)
+                    namespaceMask[namespaceId] = mNamespaces[namespaceId].sortKey == namespaceSortKey;
+
+                restrictNamespaces(namespaceMask);
+                term.text = term.text.mid(separatorIndex + 1);
+                term.isNameOnly = true;
             }
         }
 
-        const ModelSearchFilter modelTypeFilter = modelSearchFilterForTypeId(entry.typeId);
-        if (modelTypeFilter == ModelSearchFilter::None)
+        // Glob term, such as "*_L_*" or "Actor03:finger[0-4]", which matches the whole name regardless of the anchors
+        if (term.text.contains(QLatin1Char('*')) || term.text.contains(QLatin1Char('?')) || term.text.contains(QLatin1Char('[')))
+        {
+            term.pattern = getModelQueryPattern(term.text, true);
+            if (!term.pattern.regex.isValid())
+                continue;
+
+            term.kind = ModelQueryTerm::Kind::Glob;
+            term.isAnchoredStart = false;
+            term.isAnchoredEnd = false;
+            if (!term.isExcluded)
+            {
+                for (const QString &literal : term.pattern.requiredLiterals)
+                    query.characterMask |= computeCharacterMask(literal);
+            }
+        }
+
+        // Note: The rest of a scoped term might be empty, e.g. "Actor03:", which matches all the models in the namespace
+        if (term.text.isEmpty())
             continue;
 
-        // Then we check if the model type is included in the search filters
-        if (mModelSearchFilters.testFlag(modelTypeFilter))
-            out.push_back(longName);
+        term.foldedText = term.text.toCaseFolded();
+        query.isRanked = query.isRanked || term.isTokenMatchable();
+
+        // Every long name matching a positive term contains the characters of its text, or of its required literals
+        if (term.kind == ModelQueryTerm::Kind::Text && !term.isExcluded)
+            query.characterMask |= computeCharacterMask(term.text);
+        query.terms.push_back(term);
     }
 
-    // Sort model suggestions alphabetically, ignoring case
-    out.sort(Qt::CaseInsensitive);
+    if (hasTypeTerm)
+        query.typeFilters = requestedTypeFilters;
 
-    return out;
+    if (hasNamespaceTerm)
+        restrictNamespaces(requestedNamespaceMask);
+
+    if (!query.typeFilters)
+        query.isUnsatisfiable = true;
+
+    // Scan only the ranges of the included namespaces, which are contiguous in the sorted entries
+    if (query.namespaceMask.isEmpty())
+        query.entryRanges.push_back(std::make_pair(0, static_cast<int>(mModelEntries.size())));
+    else
+    {
+        for (int namespaceId = 1; namespaceId < query.namespaceMask.size(); ++namespaceId)
+        {
+            if (!query.namespaceMask[namespaceId])
+                continue;
+
+            auto rangeIt = mNamespaceRanges.constFind(mNamespaces[namespaceId].sortKey);
+            if (rangeIt != mNamespaceRanges.constEnd())
+                query.entryRanges.push_back(*rangeIt);
+        }
+
+        // Namespaces differing only by case share their range, and the ranges are scanned in display order
+        std::sort(query.entryRanges.begin(), query.entryRanges.end());
+        query.entryRanges.erase(std::unique(query.entryRanges.begin(), query.entryRanges.end()), query.entryRanges.end());
+
+        if (query.entryRanges.isEmpty())
+            query.isUnsatisfiable = true;
+    }
+
+    if (query.isUnsatisfiable)
+    {
+        query.entryRanges.clear();
+        return query;
+    }
+
+    // Find the exact match, which is pinned to the top and skipped in the scan
+    if (!query.text.isEmpty())
+    {
+        const int exactMatchIndex = findModelEntryIndex(query.text, false);
+        if (exactMatchIndex >= 0 && rankModelEntry(exactMatchIndex, query) != ModelMatchRank::None)
+            query.exactMatchIndex = exactMatchIndex;
+    }
+
+    return query;
+}
+
+bool SuggestionProvider::getModelSuggestionBatch(const ModelQuery &query, ModelSuggestionStream &stream, int maxCount, const QDeadlineTimer &deadline, QList<ModelSuggestion> &out) const
+{
+    // Number of entries scanned between the deadline checks
+    constexpr int deadlineCheckInterval = 64;
+
+    // The query might have been compiled for other entries, so keep the scan within the current entries
+    const int entryCount = std::min(static_cast<int>(mModelEntries.size()), static_cast<int>(mModelCharacterMasks.size()));
+
+    if (stream.scanIndex < 0)
+    {
+        if (query.exactMatchIndex >= 0 && query.exactMatchIndex < entryCount)
+            out.push_back(ModelSuggestion{modelEntryLongName(mModelEntries[query.exactMatchIndex]), query.exactMatchIndex});
+
+        stream.rangeIndex = 0;
+        stream.scanIndex = query.entryRanges.isEmpty() ? 0 : query.entryRanges.front().first;
+    }
+
+    int addedCount = 0;
+    int scannedCount = 0;
+
+    // Scan the ranges once, returning the entries of the best rank and deferring the others to the bucket of their rank
+    while (stream.rangeIndex < query.entryRanges.size())
+    {
+        const int endIndex = std::min(query.entryRanges[stream.rangeIndex].second, entryCount);
+        for (; stream.scanIndex < endIndex && addedCount < maxCount; ++stream.scanIndex)
+        {
+            if (++scannedCount % deadlineCheckInterval == 0 && deadline.hasExpired())
+                return false;
+
+            const int entryIndex = stream.scanIndex;
+            if (entryIndex == query.exactMatchIndex)
+                continue;
+
+            // Reject the entries missing any character of the query before testing the terms
+            if ((mModelCharacterMasks[entryIndex] & query.characterMask) != query.characterMask)
+                continue;
+
+            const ModelMatchRank rank = rankModelEntry(entryIndex, query);
+            if (rank == ModelMatchRank::None)
+                continue;
+
+            if (rank != ModelMatchRank::TokenStart)
+            {
+                stream.rankBuckets[static_cast<size_t>(rank)].push_back(entryIndex);
+                continue;
+            }
+
+            out.push_back(ModelSuggestion{modelEntryLongName(mModelEntries[entryIndex]), entryIndex});
+            addedCount++;
+        }
+
+        if (stream.scanIndex < endIndex)
+            return false;
+
+        // Step to the next range
+        if (++stream.rangeIndex < query.entryRanges.size())
+            stream.scanIndex = query.entryRanges[stream.rangeIndex].first;
+    }
+
+    // The scan is completed, so return the deferred entries rank by rank, which are already in display order
+    while (stream.drainRank < static_cast<int>(stream.rankBuckets.size()))
+    {
+        const QVector<int> &bucket = stream.rankBuckets[stream.drainRank];
+        for (; stream.drainIndex < bucket.size(); ++stream.drainIndex)
+        {
+            if (addedCount >= maxCount)
+                return false;
+
+            const int entryIndex = bucket[stream.drainIndex];
+            out.push_back(ModelSuggestion{modelEntryLongName(mModelEntries[entryIndex]), entryIndex});
+            addedCount++;
+        }
+
+        stream.drainRank++;
+        stream.drainIndex = 0;
+    }
+
+    return true;
+}
+
+FBModel *SuggestionProvider::getSuggestedModel(int entryIndex, unsigned int revision) const
+{
+    if (revision != mModelSuggestionsRevision || mModelCollectionState != ModelCollectionState::Completed)
+        return nullptr;
+
+    if (entryIndex < 0 || entryIndex >= mModelEntries.size())
+        return nullptr;
+
+    const HdlFBPlugTemplate<FBModel> &modelHandle = mModelEntries[entryIndex].model;
+    return modelHandle.Ok() ? (FBModel *)modelHandle : nullptr;
+}
+
+FBModel *SuggestionProvider::getSuggestedModelByLongName(const QString &longName) const
+{
+    if (mModelCollectionState != ModelCollectionState::Completed)
+        return nullptr;
+
+    const int entryIndex = findModelEntryIndex(longName, true);
+    if (entryIndex < 0)
+        return nullptr;
+
+    const HdlFBPlugTemplate<FBModel> &modelHandle = mModelEntries[entryIndex].model;
+    return modelHandle.Ok() ? (FBModel *)modelHandle : nullptr;
 }
 
 void SuggestionProvider::initializeOperatorSuggestions()
@@ -148,12 +496,94 @@ void SuggestionProvider::initializeOperatorSuggestions()
     mDefaultOperatorEntriesBeforeMacro.clear();
     mDefaultOperatorEntriesAfterMacro.clear();
     collectDefaultOperatorEntry();
+
+    // Index the words of the default operators once, for the typo-tolerant search
+    mDefaultOperatorWordTree.clear();
+    for (const OperatorEntry &entry : mDefaultOperatorEntriesBeforeMacro + mDefaultOperatorEntriesAfterMacro)
+        addOperatorWords(mDefaultOperatorWordTree, entry.words);
 }
 
-void SuggestionProvider::initializeModelSuggestions()
+void SuggestionProvider::invalidateModelSuggestions()
 {
+    TaskScheduler::getInstance().cancel(mModelCollectionJobId);
+    mModelCollectionJobId = 0;
+    mModelCollectionState = ModelCollectionState::NotStarted;
     mModelEntries.clear();
-    collectModelEntry();
+    mModelCharacterMasks.clear();
+    mModelNameCharacterMasks.clear();
+    mModelCharacterPositions.clear();
+    mModelCharacterPositionOffsets.clear();
+    mNamespaces.clear();
+    mNamespaceIds.clear();
+    mNamespaceRanges.clear();
+    mModelTraversalStack.clear();
+}
+
+void SuggestionProvider::requestModelSuggestions(QObject *context, std::function<void()> onCompleted)
+{
+    if (mModelCollectionState == ModelCollectionState::Completed)
+    {
+        if (onCompleted)
+            onCompleted();
+        return;
+    }
+
+    // Keep only the latest callback for each context, e.g. when the query is changed while collecting
+    auto callbackIt = std::find_if(mModelCollectionCallbacks.begin(), mModelCollectionCallbacks.end(),
+                                   [context](const auto &callback)
+                                   { return callback.first == context; });
+    if (callbackIt != mModelCollectionCallbacks.end())
+        callbackIt->second = std::move(onCompleted);
+    else
+        mModelCollectionCallbacks.emplace_back(QPointer<QObject>(context), std::move(onCompleted));
+
+    if (mModelCollectionState == ModelCollectionState::Collecting)
+        return;
+
+    startModelCollection(TaskScheduler::Priority::High);
+}
+
+void SuggestionProvider::requestWarmUp()
+{
+    QCoreApplication *application = QCoreApplication::instance();
+    if (!application || mIsWarmUpRequested.exchange(true))
+        return;
+
+    // The system callbacks might not be called in the main thread, so schedule the warm-up from the event loop
+    QMetaObject::invokeMethod(application, [this]()
+                              { TaskScheduler::getInstance().schedule([this](const QDeadlineTimer &)
+                                                                       {
+                                                                           runWarmUp();
+                                                                           return false; }); }, Qt::QueuedConnection);
+}
+
+void SuggestionProvider::prepareForInvocation(FBConstraintRelation *relation)
+{
+    mInvocationCount++;
+
+    if (isMacroCatalogReady(relation))
+        mMacroCatalogHitCount++;
+    else
+        refreshMacroCatalog(relation);
+
+    // Note: Most invocations never switch to models, so they are collected here only by the warm-up
+    if (mIsModelIndexStale.exchange(false))
+        invalidateModelSuggestions();
+    else if (mModelCollectionState == ModelCollectionState::Completed)
+        mModelIndexHitCount++;
+}
+
+void SuggestionProvider::traceSuggestionReport() const
+{
+    DIALOG_DEBUG_START;
+    DIALOG_DEBUG_MESSAGE("Suggestion warm-up hits: macros %llu/%llu, models %llu/%llu (%llu warm-ups)",
+                         mMacroCatalogHitCount, mInvocationCount, mModelIndexHitCount, mInvocationCount, mWarmUpCount);
+
+    // The entries hold their names only, instead of their names, long names and case-folded long names
+    DIALOG_DEBUG_MESSAGE("Model suggestions: %d models in %d namespaces", static_cast<int>(mModelEntries.size()), std::max(static_cast<int>(mNamespaces.size()) - 1, 0));
+    DIALOG_DEBUG_MESSAGE("Model names: %lld bytes of names and character positions, instead of %lld bytes with the long names in the entries",
+                         mModelNameBytes, mModelLongNameBytes);
+    DIALOG_DEBUG_END_NOTFAILURE;
 }
 
 void SuggestionProvider::applyConfig(const RelationDialogConfig &config)
@@ -206,28 +636,28 @@ void SuggestionProvider::collectDefaultOperatorEntry()
             if (operatorTypeName.empty() || operatorTypeName == "My Macros")
                 continue;
 
+            OperatorEntry entry{QString::fromStdString(operatorTypeName),
+                                QString::fromUtf8(operatorName)};
+            entry.characterMask = computeCharacterMask(entry.categoryName) | computeCharacterMask(entry.operatorName);
+            entry.words = splitOperatorWords(entry.categoryName) + splitOperatorWords(entry.operatorName);
+
             if (operatorTypeName < "My Macros")
-            {
-                mDefaultOperatorEntriesBeforeMacro.push_back(
-                    OperatorEntry{QString::fromStdString(operatorTypeName),
-                                  QString::fromUtf8(operatorName)});
-            }
+                mDefaultOperatorEntriesBeforeMacro.push_back(std::move(entry));
             else
-            {
-                mDefaultOperatorEntriesAfterMacro.push_back(
-                    OperatorEntry{QString::fromStdString(operatorTypeName),
-                                  QString::fromUtf8(operatorName)});
-            }
+                mDefaultOperatorEntriesAfterMacro.push_back(std::move(entry));
         }
     }
 }
 
-void SuggestionProvider::collectMyMacrosEntry(QList<OperatorEntry> &entries) const
+void SuggestionProvider::collectMyMacrosEntry(FBConstraintRelation *relation, QList<OperatorEntry> &entries) const
 {
-    FBConstraintRelation *relation = RelationDialogManager::getInstance().getLastSelectedRelationConstraint();
     if (!relation)
         return;
 
+    // The graph is only marked outdated by the scene events, so bring it up to date before filtering
+    if (mMacroDependencyGraph.isDirty())
+        mMacroDependencyGraph.rebuild();
+
     for (int i = 0; i < FBSystem::TheOne().Scene->Constraints.GetCount(); ++i)
     {
         FBConstraint *constraint = FBSystem::TheOne().Scene->Constraints[i];
@@ -242,36 +672,434 @@ void SuggestionProvider::collectMyMacrosEntry(QList<OperatorEntry> &entries) con
         if (relationConstraint == relation)
             continue;
 
-        entries.push_back(
-            OperatorEntry{"My Macros",
-                          QString::fromUtf8(relationConstraint->Name.AsString())});
+        // Adding a macro which already depends on the relation would create a recursive loop
+        if (mMacroDependencyGraph.wouldCreateCycle(relation, relationConstraint))
+            continue;
+
+        OperatorEntry entry{"My Macros",
+                            QString::fromUtf8(relationConstraint->Name.AsString())};
+        entry.characterMask = computeCharacterMask(entry.categoryName) | computeCharacterMask(entry.operatorName);
+        entry.words = splitOperatorWords(entry.categoryName) + splitOperatorWords(entry.operatorName);
+        entries.push_back(std::move(entry));
     }
 }
 
-void SuggestionProvider::collectModelEntry()
+QString SuggestionProvider::modelEntryLongName(const ModelEntry &entry) const
 {
-    if (!mModelEntries.isEmpty())
-        mModelEntries.clear();
+    if (entry.namespaceId == 0)
+        return entry.name;
 
-    FBModelList modelList;
-    FBFindModelsOfType(modelList, FBModel::TypeInfo, FBSystem::TheOne().Scene->RootModel);
+    return mNamespaces[entry.namespaceId].name + QLatin1Char(':') + entry.name;
+}
+
+int SuggestionProvider::findModelEntryIndex(const QString &longName, bool isCaseSensitive) const
+{
+    const Qt::CaseSensitivity caseSensitivity = isCaseSensitive ? Qt::CaseSensitive : Qt::CaseInsensitive;
 
-    for (int i = 0; i < modelList.GetCount(); ++i)
+    // Start without a namespace, then split the long name at each separator
+    int separatorIndex = -1;
+    do
     {
-        FBModel *model = modelList[i];
+        const QStringView nameSpace = separatorIndex < 0 ? QStringView() : QStringView(longName).left(separatorIndex);
+        const QStringView name = QStringView(longName).mid(separatorIndex + 1);
+
+        auto rangeIt = mNamespaceRanges.constFind(nameSpace.toString().toCaseFolded());
+        if (rangeIt != mNamespaceRanges.constEnd())
+        {
+            // The entries of the namespace are sorted by their names, ignoring case
+            auto isNameLess = [](const ModelEntry &entry, QStringView otherName)
+            { return QStringView(entry.name).compare(otherName, Qt::CaseInsensitive) < 0; };
 
-        // Models collected by FBFindModelsOfType contains the parent model
-        // which specified in the third argument of the function
-        // We only want to collect the children models, so we skip the scene root model
-        if (!model || model == FBSystem::TheOne().Scene->RootModel)
+            const auto first = mModelEntries.constBegin() + rangeIt->first;
+            const auto last = mModelEntries.constBegin() + rangeIt->second;
+            for (auto it = std::lower_bound(first, last, name, isNameLess); it != last && QStringView(it->name).compare(name, Qt::CaseInsensitive) == 0; ++it)
+            {
+                if (QStringView(it->name).compare(name, caseSensitivity) == 0 && QStringView(mNamespaces[it->namespaceId].name).compare(nameSpace, caseSensitivity) == 0)
+                    return static_cast<int>(it - mModelEntries.constBegin());
+            }
+        }
+
+        separatorIndex = longName.indexOf(QLatin1Char(':'), separatorIndex + 1);
+    } while (separatorIndex >= 0);
+
+    return -1;
+}
+
+ModelMatchRank SuggestionProvider::rankModelEntry(int entryIndex, const ModelQuery &query) const
+{
+    const ModelEntry &entry = mModelEntries[entryIndex];
+
+    // Check if the model type and namespace are included in the query
+    if (entry.typeFilter == ModelSearchFilter::None || !query.typeFilters.testFlag(entry.typeFilter))
+        return ModelMatchRank::None;
+
+    if (!query.includesNamespace(entry.namespaceId))
+        return ModelMatchRank::None;
+
+    // Then we check the text terms in order, keeping the worst rank of the terms
+    // Note: The tokens of the name and of the namespace are matched apart, so an acronym cannot span both
+    const NamespaceEntry &namespaceEntry = mNamespaces[entry.namespaceId];
+    const CharacterPositions namePositions{entry.name, mModelNameCharacterMasks[entryIndex],
+                                           mModelCharacterPositions.data() + mModelCharacterPositionOffsets[entryIndex]};
+    const CharacterPositions namespacePositions{namespaceEntry.name, namespaceEntry.characterMask, namespaceEntry.characterPositions.data()};
+    ModelMatchRank rank = ModelMatchRank::TokenStart;
+    for (const ModelQueryTerm &term : query.terms)
+    {
+        if (!term.isTokenMatchable())
+        {
+            if (term.matches(namespaceEntry.name, entry.name) == term.isExcluded)
+                return ModelMatchRank::None;
             continue;
+        }
+
+        ModelQueryTerm::TokenMatch tokenMatch = term.matchTokens(namePositions, entry.tokenStarts, 0);
+        if (tokenMatch != ModelQueryTerm::TokenMatch::TokenStart && !term.isNameOnly && entry.namespaceId != 0)
+            tokenMatch = std::max(tokenMatch, term.matchTokens(namespacePositions, namespaceEntry.tokenStarts, 0));
+        if (tokenMatch == ModelQueryTerm::TokenMatch::TokenStart)
+            continue;
+
+        if (term.matches(namespaceEntry.name, entry.name))
+            rank = std::max(rank, ModelMatchRank::Substring);
+        else if (tokenMatch == ModelQueryTerm::TokenMatch::Acronym)
+            rank = ModelMatchRank::Acronym;
+        else
+            return ModelMatchRank::None;
+    }
 
-        FBNamespace *nameSpace = model->GetOwnerNamespace();
-        QString nameSpaceStr = nameSpace ? QString::fromUtf8(nameSpace->Name.AsString()) : QString();
+    return rank;
+}
+
+QVector<bool> SuggestionProvider::namespaceMaskForName(const QString &name) const
+{
+    QVector<bool> namespaceMask(mNamespaces.size(), false);
+    const QString sortKey = name.toCaseFolded();
+
+    // Exact match, ignoring case
+    bool isExactMatchFound = false;
+    for (int namespaceId = 1; namespaceId < mNamespaces.size(); ++namespaceId)
+    {
+        if (mNamespaces[namespaceId].sortKey == sortKey)
+        {
+            namespaceMask[namespaceId] = true;
+            isExactMatchFound = true;
+        }
+    }
+
+    if (isExactMatchFound)
+        return namespaceMask;
+
+    // Prefix match, e.g. while the name is being typed
+    for (int namespaceId = 1; namespaceId < mNamespaces.size(); ++namespaceId)
+        namespaceMask[namespaceId] = mNamespaces[namespaceId].sortKey.startsWith(sortKey);
+
+    return namespaceMask;
+}
+
+QList<const SuggestionProvider::OperatorEntry *> SuggestionProvider::findOperatorEntriesWithTypos(const QString &query, const QList<OperatorEntry> &operatorEntries,
+                                                                                                  const BKTree &macroWordTree) const
+{
+    QList<const OperatorEntry *> matchedEntries;
+
+    // Find the catalog words close to each word of the query
+    const QStringList queryWords = splitOperatorWords(query);
+    if (queryWords.isEmpty())
+        return matchedEntries;
+
+    QList<QHash<QString, int>> closeWords;
+    for (const QString &queryWord : queryWords)
+    {
+        const int maxDistance = queryWord.size() < 3 ? 0 : (queryWord.size() <= 4 ? 1 : 2);
+
+        QHash<QString, int> wordDistances;
+        mDefaultOperatorWordTree.findWithin(queryWord, maxDistance, wordDistances);
+        macroWordTree.findWithin(queryWord, maxDistance, wordDistances);
+        if (wordDistances.isEmpty())
+            return matchedEntries;
+
+        closeWords.push_back(std::move(wordDistances));
+    }
+
+    // Keep the entries having a close word for each word of the query, with the total distance
+    std::vector<std::pair<int, const OperatorEntry *>> scoredEntries;
+    // Note: The words of the entries are split once when the entries are collected
+    for (const auto &entry : operatorEntries)
+    {
+        int totalDistance = 0;
+        bool isMatched = true;
+        for (const QHash<QString, int> &wordDistances : closeWords)
+        {
+            int bestDistance = -1;
+            for (const QString &entryWord : entry.words)
+            {
+                const int distance = wordDistances.value(entryWord, -1);
+                if (distance >= 0 && (bestDistance < 0 || distance < bestDistance))
+                    bestDistance = distance;
+            }
+
+            if (bestDistance < 0)
+            {
+                isMatched = false;
+                break;
+            }
+            totalDistance += bestDistance;
+        }
+
+        if (isMatched)
+            scoredEntries.emplace_back(totalDistance, &entry);
+    }
+
+    std::stable_sort(scoredEntries.begin(), scoredEntries.end(), [](const auto &lhs, const auto &rhs)
+                     { return lhs.first < rhs.first; });
+
+    for (const auto &scoredEntry : scoredEntries)
+        matchedEntries.push_back(scoredEntry.second);
+
+    return matchedEntries;
+}
+
+ModelQueryPattern SuggestionProvider::getModelQueryPattern(const QString &pattern, bool isGlob) const
+{
+    constexpr int patternCacheCapacity = 64;
 
-        mModelEntries.push_back(
-            ModelEntry{nameSpaceStr,
-                       QString::fromUtf8(model->Name.AsString()),
-                       model->GetTypeId()});
+    const QString key = (isGlob ? QLatin1String("glob:") : QLatin1String("regex:")) + pattern;
+    const auto it = mModelQueryPatterns.constFind(key);
+    if (it != mModelQueryPatterns.constEnd())
+        return it.value();
+
+    if (mModelQueryPatterns.size() >= patternCacheCapacity)
+        mModelQueryPatterns.clear();
+
+    const ModelQueryPattern compiled = compileModelQueryPattern(pattern, isGlob);
+    mModelQueryPatterns.insert(key, compiled);
+    return compiled;
+}
+
+bool SuggestionProvider::isMacroCatalogReady(FBConstraintRelation *relation) const
+{
+    if (mIsMacroCatalogStale || !mMacroCatalogRelation.Ok())
+        return false;
+
+    return (FBConstraintRelation *)mMacroCatalogRelation == relation;
+}
+
+void SuggestionProvider::refreshMacroCatalog(FBConstraintRelation *relation)
+{
+    // Clear the flag first, so changes notified while collecting mark the catalog outdated again
+    mIsMacroCatalogStale = false;
+
+    mMacroCatalogRelation = relation;
+    mMacroEntries.clear();
+    collectMyMacrosEntry(relation, mMacroEntries);
+
+    mMacroWordTree.clear();
+    for (const OperatorEntry &entry : mMacroEntries)
+        addOperatorWords(mMacroWordTree, entry.words);
+}
+
+void SuggestionProvider::runWarmUp()
+{
+    mIsWarmUpRequested = false;
+    mWarmUpCount++;
+
+    // The warm-up is requested on the relation selection, so the catalog is collected for the selected relation
+    FBConstraintRelation *relation = RelationDialogManager::getInstance().getLastSelectedRelationConstraint();
+    if (!isMacroCatalogReady(relation))
+        refreshMacroCatalog(relation);
+
+    if (mIsModelIndexStale.exchange(false))
+        invalidateModelSuggestions();
+
+    if (mModelCollectionState == ModelCollectionState::NotStarted)
+        startModelCollection(TaskScheduler::Priority::Normal);
+}
+
+void SuggestionProvider::startModelCollection(TaskScheduler::Priority priority)
+{
+    mModelCollectionState = ModelCollectionState::Collecting;
+
+    // The first interned namespace is the empty one, for the models without namespace
+    mNamespaces.clear();
+    mNamespaces.push_back(NamespaceEntry{});
+
+    // Start the traversal from the children of the scene root model, the root itself is not a suggestion
+    FBModel *rootModel = FBSystem::TheOne().Scene->RootModel;
+    for (int i = rootModel->Children.GetCount() - 1; i >= 0; --i)
+        mModelTraversalStack.emplace_back(rootModel->Children[i]);
+
+    // Collect with high priority if the user is already waiting for the suggestion list
+    if (!mModelCollectionCallbacks.empty())
+        priority = TaskScheduler::Priority::High;
+
+    mModelCollectionJobId = TaskScheduler::getInstance().schedule(
+        [this](const QDeadlineTimer &deadline)
+        { return collectModelEntryStep(deadline); },
+        priority,
+        [this]()
+        { onModelCollectionCompleted(); });
+}
+
+bool SuggestionProvider::collectModelEntryStep(const QDeadlineTimer &deadline)
+{
+    while (!mModelTraversalStack.empty() && !deadline.hasExpired())
+    {
+        // Models can be deleted between slices, so they are held with handles
+        HdlFBPlugTemplate<FBModel> modelHandle = mModelTraversalStack.back();
+        mModelTraversalStack.pop_back();
+
+        if (!modelHandle.Ok())
+            continue;
+
+        FBModel *model = modelHandle;
+
+        ModelEntry entry;
+        entry.namespaceId = internNamespace(model->GetOwnerNamespace());
+        entry.name = QString::fromUtf8(model->Name.AsString());
+
+        entry.tokenStarts = computeTokenStartMask(entry.name);
+        entry.typeFilter = modelSearchFilterForTypeId(model->GetTypeId());
+        entry.model = model;
+        mModelEntries.push_back(std::move(entry));
+
+        // Push the children in reverse order, so they are visited in order
+        for (int i = model->Children.GetCount() - 1; i >= 0; --i)
+            mModelTraversalStack.emplace_back(model->Children[i]);
+    }
+
+    return !mModelTraversalStack.empty();
+}
+
+int SuggestionProvider::internNamespace(FBNamespace *nameSpace)
+{
+    if (!nameSpace)
+        return 0;
+
+    auto it = mNamespaceIds.find(nameSpace);
+    if (it != mNamespaceIds.end())
+        return it->second;
+
+    NamespaceEntry namespaceEntry;
+    namespaceEntry.name = QString::fromUtf8(nameSpace->Name.AsString());
+    namespaceEntry.sortKey = namespaceEntry.name.toCaseFolded();
+    namespaceEntry.tokenStarts = computeTokenStartMask(namespaceEntry.name);
+    namespaceEntry.characterMask = computeCharacterMask(namespaceEntry.name);
+    appendCharacterPositions(namespaceEntry.name, namespaceEntry.characterMask, namespaceEntry.characterPositions);
+
+    // An empty namespace name is the same as no namespace
+    const int namespaceId = namespaceEntry.name.isEmpty() ? 0 : mNamespaces.size();
+    if (namespaceId != 0)
+        mNamespaces.push_back(std::move(namespaceEntry));
+
+    mNamespaceIds.emplace(nameSpace, namespaceId);
+    return namespaceId;
+}
+
+void SuggestionProvider::indexNamespaceRanges()
+{
+    mNamespaceRanges.clear();
+
+    // The entries are sorted by their namespaces first, so the entries in the same case-folded namespace are contiguous
+    qint64 modelNameBytes = 0;
+    qint64 modelLongNameBytes = 0;
+    for (int i = 0; i < mModelEntries.size(); ++i)
+    {
+        const ModelEntry &entry = mModelEntries[i];
+        const NamespaceEntry &namespaceEntry = mNamespaces[entry.namespaceId];
+
+        // A long name without a namespace would share the data of the name, but a case-folded long name would not.
+        // The position bitmasks of a long name would cover the characters of both the namespace and the name.
+        const qint64 nameLength = entry.name.size();
+        const qint64 longNameLength = entry.namespaceId == 0 ? nameLength : namespaceEntry.name.size() + 1 + nameLength;
+        modelNameBytes += nameLength * static_cast<qint64>(sizeof(QChar));
+        modelLongNameBytes += (nameLength + (entry.namespaceId == 0 ? 0 : longNameLength) + longNameLength) * static_cast<qint64>(sizeof(QChar));
+        modelLongNameBytes += qPopulationCount(mModelCharacterMasks[i]) * static_cast<qint64>(sizeof(quint64));
+
+        auto rangeIt = mNamespaceRanges.find(namespaceEntry.sortKey);
+        if (rangeIt == mNamespaceRanges.end())
+            mNamespaceRanges.insert(namespaceEntry.sortKey, std::make_pair(i, i + 1));
+        else
+            rangeIt->second = i + 1;
+    }
+    modelNameBytes += static_cast<qint64>(mModelCharacterPositions.size() * sizeof(quint64));
+
+    // Keep the memory figures for traceSuggestionReport(), where both layouts intern the namespaces
+    for (const NamespaceEntry &namespaceEntry : mNamespaces)
+    {
+        const qint64 namespaceBytes = (namespaceEntry.name.size() + namespaceEntry.sortKey.size()) * static_cast<qint64>(sizeof(QChar));
+        modelNameBytes += namespaceBytes + static_cast<qint64>(namespaceEntry.characterPositions.size() * sizeof(quint64));
+        modelLongNameBytes += namespaceBytes;
+    }
+
+    mModelNameBytes = modelNameBytes;
+    mModelLongNameBytes = modelLongNameBytes;
+}
+
+void SuggestionProvider::onModelCollectionCompleted()
+{
+    mModelCollectionJobId = 0;
+
+    // Rank the namespaces by their case-folded names, so the entries are sorted without building their long names
+    QVector<int> namespaceIdsBySortKey(mNamespaces.size());
+    std::iota(namespaceIdsBySortKey.begin(), namespaceIdsBySortKey.end(), 0);
+    std::sort(namespaceIdsBySortKey.begin(), namespaceIdsBySortKey.end(), [this](int lhs, int rhs)
+              { return mNamespaces[lhs].sortKey < mNamespaces[rhs].sortKey; });
+
+    // Namespaces differing only by case share their rank, so their entries are contiguous
+    QVector<int> namespaceRanks(mNamespaces.size(), 0);
+    for (int i = 1; i < namespaceIdsBySortKey.size(); ++i)
+    {
+        const int namespaceId = namespaceIdsBySortKey[i];
+        const int previousNamespaceId = namespaceIdsBySortKey[i - 1];
+        namespaceRanks[namespaceId] = namespaceRanks[previousNamespaceId] + (mNamespaces[namespaceId].sortKey == mNamespaces[previousNamespaceId].sortKey ? 0 : 1);
+    }
+
+    // Sort once here, so the suggestions can be streamed in display order without sorting per query
+    auto compareEntries = [&namespaceRanks](const ModelEntry &lhs, const ModelEntry &rhs)
+    {
+        const int lhsRank = namespaceRanks[lhs.namespaceId];
+        const int rhsRank = namespaceRanks[rhs.namespaceId];
+        if (lhsRank != rhsRank)
+            return lhsRank < rhsRank;
+
+        return lhs.name.compare(rhs.name, Qt::CaseInsensitive) < 0;
+    };
+    std::sort(mModelEntries.begin(), mModelEntries.end(), compareEntries);
+
+    // Compute the character masks for the prefilter and the character positions for the token matching,
+    // in the order of the sorted entries, so the queries do not scan the names for each character
+    const quint64 separatorMask = computeCharacterMask(QStringLiteral(":"));
+    mModelCharacterMasks.clear();
+    mModelCharacterMasks.reserve(mModelEntries.size());
+    mModelNameCharacterMasks.clear();
+    mModelNameCharacterMasks.reserve(mModelEntries.size());
+    mModelCharacterPositions.clear();
+    mModelCharacterPositionOffsets.clear();
+    mModelCharacterPositionOffsets.reserve(mModelEntries.size() + 1);
+    for (const ModelEntry &entry : mModelEntries)
+    {
+        const quint64 nameCharacterMask = computeCharacterMask(entry.name);
+        const quint64 namespaceCharacterMask = entry.namespaceId == 0 ? 0 : mNamespaces[entry.namespaceId].characterMask | separatorMask;
+        mModelCharacterMasks.push_back(nameCharacterMask | namespaceCharacterMask);
+        mModelNameCharacterMasks.push_back(nameCharacterMask);
+        mModelCharacterPositionOffsets.push_back(static_cast<int>(mModelCharacterPositions.size()));
+        appendCharacterPositions(entry.name, nameCharacterMask, mModelCharacterPositions);
+    }
+    mModelCharacterPositionOffsets.push_back(static_cast<int>(mModelCharacterPositions.size()));
+
+    indexNamespaceRanges();
+
+    // The namespaces are only looked up by pointer while collecting
+    mNamespaceIds.clear();
+
+    mModelSuggestionsRevision++;
+    mModelCollectionState = ModelCollectionState::Completed;
+
+    // Callbacks might request the suggestions again, so move them out before calling
+    auto callbacks = std::move(mModelCollectionCallbacks);
+    mModelCollectionCallbacks.clear();
+
+    for (auto &callback : callbacks)
+    {
+        if (callback.first && callback.second)
+            callback.second();
     }
 }
\ No newline at end of file
@@ -1,11 +1,29 @@
 #pragma once
 
+#include <array>
+#include <atomic>
+#include <functional>
+#include <unordered_map>
+#include <utility>
+#include <vector>
+
+#include <QtCore/QDeadlineTimer>
+#include <QtCore/QHash>
 #include <QtCore/QList>
+#include <QtCore/QObject>
+#include <QtCore/QPointer>
 #include <QtCore/QString>
 #include <QtCore/QStringList>
 #include <QtCore/QStringView>
+#include <QtCore/QVector>
+
+#include <fbsdk/fbsdk.h>
 
+#include "BKTree.h"
+#include "MacroDependencyGraph.h"
+#include "ModelQuery.h"
 #include "RelationDialogConfig.h"
+#include "TaskScheduler.h"
 
 /**
  * @class SuggestionProvider
@@ -14,25 +32,92 @@
 class SuggestionProvider
 {
 public:
+    /**
+     * @struct ModelSuggestion
+     * @brief Struct to hold a model suggestion returned by getModelSuggestionBatch
+     */
+    struct ModelSuggestion
+    {
+        QString longName;    //!< Long name shown in the suggestion list, formatted as "Namespace:Name" or "Name"
+        int entryIndex = -1; //!< Index of the model entry, to resolve the model with getSuggestedModel
+    };
+
+    /**
+     * @struct ModelSuggestionStream
+     * @brief State of the model suggestions of a query, resumed by each getModelSuggestionBatch call
+     * @details Each entry is ranked once while scanning. The entries of the best rank are returned during the scan,
+     *          and the others are kept in buckets by rank, which are returned in order once the scan is completed.
+     * @note The state is only valid for the same getModelSuggestionsRevision() value.
+     */
+    struct ModelSuggestionStream
+    {
+        int scanIndex = -1;                                                              //!< Index of the model entry to resume the scan from, -1 before the first batch
+        int rangeIndex = 0;                                                              //!< Index of the ModelQuery::entryRanges element being scanned
+        std::array<QVector<int>, static_cast<size_t>(ModelMatchRank::None)> rankBuckets; //!< Indices of the matching entries waiting for the scan to complete, by rank
+        int drainRank = 0;                                                               //!< Rank of the bucket being returned after the scan
+        int drainIndex = 0;                                                              //!< Position in the bucket being returned
+    };
+
     /**
      * @brief Get operator suggestions based on the query string
      * @details This function is called by SearchDialog to retrieve operator suggestions matching the user's query.
      *          It combines default operators and "My Macros" operators, applies the search priority and filtering
      *          based on the query, and returns a list of formatted suggestion strings.
+     *          When no entry contains the query, the entries whose words are within a small edit distance
+     *          of the words of the query are suggested instead, so typos such as "Multipy" still find "Multiply".
      * @param queryView The query string to filter operator suggestions
+     * @param relation The relation constraint of the dialog, in which the macros would be created
      * @return A list of operator suggestions matching the query, formatted as "Category - Operator"
      */
-    QStringList getOperatorSuggestions(QStringView queryView) const;
+    QStringList getOperatorSuggestions(QStringView queryView, FBConstraintRelation *relation) const;
 
     /**
-     * @brief Get model suggestions based on the query string and search filters
+     * @brief Compile the query string of the search box into a ModelQuery
+     * @details Type terms without any matching type, and namespace terms without any matching namespace, make the query unsatisfiable.
+     *          Without type terms, the model search filters of the configuration are used.
+     * @param queryView The query string to compile
+     * @return The compiled query, valid for the current getModelSuggestionsRevision() value
+     */
+    ModelQuery compileModelQuery(QStringView queryView) const;
+
+    /**
+     * @brief Get a batch of model suggestions matching a compiled query
      * @details This function is called by SearchDialog to retrieve model suggestions matching the user's query.
-     *          It applies the search filters and returns a list of formatted suggestion strings.
-     * @param queryView The query string to filter model suggestions
-     * @return A list of model suggestions matching the query and search filters, formatted as "Namespace:Name"
-     *         or "Name" if namespace is empty
+     *          The model entries are sorted by their namespaces and then their names when collected, so the batches come in display order
+     *          and the first screenful can be shown before all the entries are scanned.
+     *          A model whose long name equals the query, ignoring case, is pinned to the top of the first batch.
+     *          Queries restricted to namespaces only scan the ranges of the entries in those namespaces, skipping the others.
+     *          Ranked queries list the entries by ModelMatchRank first, ranking each entry once per stream.
+     * @param query The compiled query
+     * @param stream The state of the stream, default constructed for the first batch and updated to resume the next batch from
+     * @param maxCount The maximum number of suggestions to append, not counting the pinned exact match
+     * @param deadline The deadline after which the scan stops even if fewer suggestions are appended
+     * @param out The list to append the suggestions to
+     * @return true if all the entries have been scanned, false if more batches remain
+     */
+    bool getModelSuggestionBatch(const ModelQuery &query, ModelSuggestionStream &stream, int maxCount, const QDeadlineTimer &deadline, QList<ModelSuggestion> &out) const;
+
+    /**
+     * @brief Get the model of a suggestion returned by getModelSuggestionBatch
+     * @param entryIndex The ModelSuggestion::entryIndex value
+     * @param revision The getModelSuggestionsRevision() value when the suggestion was returned
+     * @return Pointer to the FBModel, or nullptr if the models have been collected again or the model has been deleted
+     */
+    FBModel *getSuggestedModel(int entryIndex, unsigned int revision) const;
+
+    /**
+     * @brief Get the model of a suggestion by its long name in the current collection
+     * @details Used when the suggestion was returned for an older revision, so its entry index no longer applies.
+     * @param longName The ModelSuggestion::longName value
+     * @return Pointer to the FBModel, or nullptr if the collection is not completed or no live model has the long name
      */
-    QStringList getModelSuggestions(QStringView queryView) const;
+    FBModel *getSuggestedModelByLongName(const QString &longName) const;
+
+    /**
+     * @brief Get the revision of the collected model suggestions
+     * @return The revision, incremented each time a collection is completed
+     */
+    unsigned int getModelSuggestionsRevision() const { return mModelSuggestionsRevision; }
 
     /**
      * @brief Initialize operator suggestions by collecting all system and plugin operators
@@ -42,11 +127,66 @@ public:
     void initializeOperatorSuggestions();
 
     /**
-     * @brief Initialize model suggestions by collecting all scene models
-     * @note This function is called when the dialog is opened to ensure that the model suggestions are up-to-date
-     *       with the current scene content.
+     * @brief Discard the collected model suggestions and cancel the collection in progress
+     * @note The models are collected again on the next warm-up or requestModelSuggestions call.
+     */
+    void invalidateModelSuggestions();
+
+    /**
+     * @brief Request the warm-up of the suggestion data for the selected relation constraint
+     * @details Schedules a job with normal priority which refreshes the macro catalog for the selected relation constraint
+     *          and starts collecting the scene models, so the next invocation of SearchDialog finds them ready.
+     * @note This function can be called from any thread. Requests made while a warm-up is pending are coalesced.
      */
-    void initializeModelSuggestions();
+    void requestWarmUp();
+
+    /**
+     * @brief Mark the collected model suggestions as outdated, e.g. when a model is added, removed or renamed
+     * @note This function can be called from any thread. The models are collected again on the next warm-up or invocation.
+     */
+    void markModelSuggestionsStale() { mIsModelIndexStale = true; }
+
+    /**
+     * @brief Mark the macro catalog as outdated, e.g. when a relation constraint or a macro box is added, removed or renamed
+     * @note This function can be called from any thread. The catalog is refreshed on the next warm-up or invocation.
+     */
+    void markMacroSuggestionsStale()
+    {
+        mMacroDependencyGraph.markDirty();
+        mIsMacroCatalogStale = true;
+    }
+
+    /**
+     * @brief Prepare the suggestion data for an invocation of SearchDialog
+     * @details Discards the outdated data, refreshes the macro catalog if the warm-up did not, and records
+     *          whether the macro catalog and the model suggestions were warmed up in time.
+     * @param relation The relation constraint of the dialog
+     * @note This function is called when the dialog is opened.
+     */
+    void prepareForInvocation(FBConstraintRelation *relation);
+
+    /**
+     * @brief Output how often the warm-up had the suggestion data ready when SearchDialog was opened,
+     *        and the memory figures of the interned model namespaces
+     * @note This is called on demand from the settings menu of SearchDialog, not on each invocation.
+     */
+    void traceSuggestionReport() const;
+
+    /**
+     * @brief Request the model suggestions, starting the collection of scene models if not started yet
+     * @details The scene models are collected by the TaskScheduler in time-sliced steps, so the UI is not blocked
+     *          even with a large scene.
+     * @param context The QObject to receive the completion. The callback is discarded if it is destroyed.
+     * @param onCompleted The callback called in the event loop when the collection is completed
+     * @note If the collection is already completed, onCompleted is called immediately.
+     */
+    void requestModelSuggestions(QObject *context, std::function<void()> onCompleted);
+
+    /**
+     * @brief Check if the model suggestions are collected and ready for getModelSuggestionBatch
+     * @return true if the collection is completed, false otherwise
+     */
+    bool isModelCollectionCompleted() const { return mModelCollectionState == ModelCollectionState::Completed; }
 
     /**
      * @brief Apply the given configuration to the SuggestionProvider
@@ -71,8 +211,10 @@ private:
      */
     struct OperatorEntry
     {
-        QString categoryName; //!< Category name for the operator (e.g., "Boolean", "Converters")
-        QString operatorName; //!< Name of the operator
+        QString categoryName;      //!< Category name for the operator (e.g., "Boolean", "Converters")
+        QString operatorName;      //!< Name of the operator
+        quint64 characterMask = 0; //!< Characters of the category and operator names, see computeCharacterMask()
+        QStringList words;         //!< Case-folded words of the category and operator names, for the typo-tolerant search
     };
 
     /**
@@ -81,9 +223,11 @@ private:
      */
     struct ModelEntry
     {
-        QString nameSpace; //!< Namespace of the model
-        QString name;      //!< Name of the model
-        int typeId = -1;   //!< FBComponent::GetTypeId() value
+        int namespaceId = 0;                                    //!< Index of the interned namespace in mNamespaces, 0 if none
+        QString name;                                           //!< Name of the model, the long name is built from the namespace on demand
+        quint64 tokenStarts = 0;                                //!< Token-start bitmask of the name, see computeTokenStartMask()
+        ModelSearchFilter typeFilter = ModelSearchFilter::None; //!< Search filter matching the type of the model
+        HdlFBPlugTemplate<FBModel> model;                       //!< Handle to the model, to resolve a picked suggestion directly
     };
 
     /**
@@ -115,18 +259,190 @@ private:
     /**
      * @brief Collect "My Macros" operators as OperatorEntry for suggestions
      * @details Collects macro relation operators based on the currently existing relation constraint in the scene.
+     *          Macros which would create a recursive loop in the relation constraint are skipped, if the dependency graph is up-to-date.
+     * @param relation The relation constraint in which the macros are created
+     * @param entries List of entries to add to
+     */
+    void collectMyMacrosEntry(FBConstraintRelation *relation, QList<OperatorEntry> &entries) const;
+
+    /**
+     * @struct NamespaceEntry
+     * @brief Struct to hold an interned namespace shared by the model entries
+     */
+    struct NamespaceEntry
+    {
+        QString name;                            //!< Name of the namespace
+        QString sortKey;                         //!< Case-folded name of the namespace
+        quint64 tokenStarts = 0;                 //!< Token-start bitmask of the name, see computeTokenStartMask()
+        quint64 characterMask = 0;               //!< Characters of the name, see computeCharacterMask()
+        std::vector<quint64> characterPositions; //!< Character positions of the name, see appendCharacterPositions()
+    };
+
+    /**
+     * @brief Build the long name of a model entry, shown in the suggestion list
+     * @param entry The model entry
+     * @return The name prefixed with the namespace as "Namespace:Name", or the name if the entry has no namespace
+     */
+    QString modelEntryLongName(const ModelEntry &entry) const;
+
+    /**
+     * @brief Find a model entry by its long name
+     * @details The long name is split at each ":" in turn, as the namespace or the name might contain one,
+     *          and the name is searched in the sorted range of the namespace.
+     * @param longName The long name formatted as "Namespace:Name" or "Name"
+     * @param isCaseSensitive true to match the case of the long name, false to ignore it
+     * @return The index of the first matching entry, -1 if none
+     */
+    int findModelEntryIndex(const QString &longName, bool isCaseSensitive) const;
+
+    /**
+     * @brief Rank how well a model entry matches a compiled query
+     * @details The text terms which can match the tokens are tested with the token-start bitmask
+     *          and the character positions of the entry, and the rank of the entry is the worst rank of its terms.
+     * @param entryIndex The index of the model entry to check
+     * @param query The compiled query
+     * @return The rank of the entry, ModelMatchRank::None if the entry should not be suggested
+     */
+    ModelMatchRank rankModelEntry(int entryIndex, const ModelQuery &query) const;
+
+    /**
+     * @brief Get the namespaces matching a "ns:" query term
+     * @details A name matches a namespace exactly, ignoring case. Otherwise it matches all the namespaces which start with it.
+     * @param name The name after "ns:"
+     * @return Flags indexed by namespace id
+     */
+    QVector<bool> namespaceMaskForName(const QString &name) const;
+
+    /**
+     * @brief Get the operator entries whose words are within a small edit distance of the words of a query
+     * @details Each word of the query must be within the distance of a word of the category or the operator name.
+     *          The distance is 0 for words shorter than 3 characters, 1 for words up to 4 characters and 2 for longer words.
+     * @param query The trimmed query string
+     * @param operatorEntries The operator entries to search, in display order
+     * @param macroWordTree The word tree of the "My Macros" entries in operatorEntries
+     * @return The matching entries, sorted by the total distance and then in display order
      */
-    void collectMyMacrosEntry(QList<OperatorEntry> &entries) const;
+    QList<const OperatorEntry *> findOperatorEntriesWithTypos(const QString &query, const QList<OperatorEntry> &operatorEntries,
+                                                              const BKTree &macroWordTree) const;
 
     /**
-     * @brief Collect all scene models as ModelEntry for suggestions
+     * @brief Get a compiled glob or regular expression of a query term, compiling it if not cached yet
+     * @details The cache is kept across keystrokes, so the patterns of the terms which are not being edited are compiled once.
+     *          The cache is cleared when it is full, as the patterns typed earlier are unlikely to be used again.
+     * @param pattern The pattern text, without the operators of the term
+     * @param isGlob true if the pattern is a glob, false if it is a regular expression
+     * @return The compiled pattern, whose regex is invalid if the pattern has a syntax error
      */
-    void collectModelEntry();
+    ModelQueryPattern getModelQueryPattern(const QString &pattern, bool isGlob) const;
+
+    /**
+     * @brief Get the interned namespace of a model, adding it to mNamespaces if not interned yet
+     * @param nameSpace The namespace of the model, or nullptr if none
+     * @return The index of the namespace in mNamespaces, 0 if none
+     */
+    int internNamespace(FBNamespace *nameSpace);
+
+    /**
+     * @brief Compute the range of the sorted model entries in each namespace, and the memory figures of the model names
+     */
+    void indexNamespaceRanges();
+
+    /**
+     * @brief Check if the macro catalog is up-to-date for a relation constraint
+     * @param relation The relation constraint in which the macros would be created
+     * @return true if the catalog can be used, false if it must be refreshed
+     */
+    bool isMacroCatalogReady(FBConstraintRelation *relation) const;
+
+    /**
+     * @brief Collect the macro catalog for a relation constraint
+     * @details Rebuilds the macro dependency graph first if it is outdated.
+     * @param relation The relation constraint in which the macros would be created
+     */
+    void refreshMacroCatalog(FBConstraintRelation *relation);
+
+    /**
+     * @brief Run the warm-up of the suggestion data
+     * @details Refreshes the outdated macro catalog, and starts the collection of the scene models if not started yet.
+     */
+    void runWarmUp();
+
+    /**
+     * @brief Start the time-sliced collection of scene models
+     * @param priority The priority of the collection job
+     */
+    void startModelCollection(TaskScheduler::Priority priority);
+
+    /**
+     * @brief Collect scene models as ModelEntry for suggestions until the deadline of the slice expires
+     * @details Traverses the model hierarchy with mModelTraversalStack.
+     * @param deadline The deadline of the current TaskScheduler slice
+     * @return true if models remain, false if the collection is completed
+     */
+    bool collectModelEntryStep(const QDeadlineTimer &deadline);
+
+    /**
+     * @brief Sort the collected models, mark the collection as completed and call the waiting callbacks
+     */
+    void onModelCollectionCompleted();
 
 private:
+    /**
+     * @enum ModelCollectionState
+     * @brief State of the time-sliced collection of scene models
+     */
+    enum class ModelCollectionState
+    {
+        NotStarted,
+        Collecting,
+        Completed
+    };
+
     QList<OperatorEntry> mDefaultOperatorEntriesBeforeMacro; //!< Operator entries that are always shown before macro operators
     QList<OperatorEntry> mDefaultOperatorEntriesAfterMacro;  //!< Operator entries that are always shown after macro operators
-    QList<ModelEntry> mModelEntries;                         //!< Model entries collected from the scene
+    QList<OperatorEntry> mMacroEntries;                      //!< Catalog of "My Macros" operator entries for mMacroCatalogRelation
+    BKTree mDefaultOperatorWordTree;                         //!< Case-folded words of the default operator entries, for the typo-tolerant search
+    BKTree mMacroWordTree;                                   //!< Case-folded words of mMacroEntries, for the typo-tolerant search
+    QList<ModelEntry> mModelEntries;                         //!< Model entries collected from the scene, sorted by their namespaces and then their names
+    QList<NamespaceEntry> mNamespaces;                       //!< Interned namespaces of the model entries, the first one is the empty namespace
+
+    /// Character masks of the long names of mModelEntries in the same order, kept apart so the prefilter scans contiguous memory
+    std::vector<quint64> mModelCharacterMasks;
+
+    /// Character masks of the names of mModelEntries, which index their position bitmasks
+    std::vector<quint64> mModelNameCharacterMasks;
+
+    /// Character positions of the names of mModelEntries, see appendCharacterPositions(),
+    /// and the offset of the first position bitmask of each entry, with one more offset for the end
+    std::vector<quint64> mModelCharacterPositions;
+    std::vector<int> mModelCharacterPositionOffsets;
+
+    std::unordered_map<FBNamespace *, int> mNamespaceIds; //!< Index in mNamespaces of each namespace met while collecting
+    QHash<QString, std::pair<int, int>> mNamespaceRanges; //!< Range [begin, end) of the sorted model entries in each case-folded namespace, keyed by an empty string if none
+
+    mutable QHash<QString, ModelQueryPattern> mModelQueryPatterns; //!< Compiled patterns of the query terms, keyed by the kind and the pattern text
+
+    mutable MacroDependencyGraph mMacroDependencyGraph;            //!< Dependency graph of the macros, rebuilt on use when outdated
+    HdlFBPlugTemplate<FBConstraintRelation> mMacroCatalogRelation; //!< Relation constraint for which the macro catalog was collected
+    std::atomic<bool> mIsMacroCatalogStale = false;                //!< Flag indicating that the macro catalog must be refreshed
+    std::atomic<bool> mIsModelIndexStale = false;                  //!< Flag indicating that the collected models must be discarded
+    std::atomic<bool> mIsWarmUpRequested = false;                  //!< Flag to coalesce the warm-up requests into one job
+
+    ModelCollectionState mModelCollectionState = ModelCollectionState::NotStarted; //!< State of the model collection
+    TaskScheduler::JobId mModelCollectionJobId = 0;                                //!< Identifier of the model collection job, to cancel it on invalidation
+    unsigned int mModelSuggestionsRevision = 0;                                    //!< Incremented each time the model collection is completed
+    std::vector<HdlFBPlugTemplate<FBModel>> mModelTraversalStack;                  //!< Models whose entries and children are not collected yet
+
+    /// Callbacks waiting for the completion of the model collection, with their context objects
+    std::vector<std::pair<QPointer<QObject>, std::function<void()>>> mModelCollectionCallbacks;
+
+    unsigned long long mWarmUpCount = 0;          //!< Number of warm-ups run
+    unsigned long long mMacroCatalogHitCount = 0; //!< Number of invocations which found the macro catalog ready
+    unsigned long long mModelIndexHitCount = 0;   //!< Number of invocations which found the model suggestions ready
+    unsigned long long mInvocationCount = 0;      //!< Number of invocations of SearchDialog
+
+    qint64 mModelNameBytes = 0;     //!< Bytes of the characters of the model names and the interned namespaces
+    qint64 mModelLongNameBytes = 0; //!< Bytes of the characters if each model entry held its long name and case-folded long name
 
     OperatorSearchPriority mOperatorSearchPriority = OperatorSearchPriority::OperatorFirst; //!< Search priority for operators in SearchDialog
     ModelSearchFilters mModelSearchFilters = ModelSearchFilter::None;                       //!< Search filters for models in SearchDialog
@@ -0,0 +1,135 @@
+#include "TaskScheduler.h"
+
+#include <algorithm>
+#include <utility>
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QTimer>
+
+TaskScheduler::JobId TaskScheduler::schedule(JobStep step, Priority priority, std::function<void()> onCompleted)
+{
+    Job job;
+    job.id = mNextJobId++;
+    job.step = std::move(step);
+    job.onCompleted = std::move(onCompleted);
+
+    const JobId jobId = job.id;
+    mJobQueues[static_cast<size_t>(priority)].push_back(std::move(job));
+
+    requestSlice();
+    return jobId;
+}
+
+bool TaskScheduler::cancel(JobId jobId)
+{
+    if (jobId == 0)
+        return false;
+
+    // The running job is removed after its step returns
+    if (jobId == mRunningJobId)
+    {
+        mIsRunningJobCancelled = true;
+        return true;
+    }
+
+    for (auto &queue : mJobQueues)
+    {
+        auto it = std::find_if(queue.begin(), queue.end(), [jobId](const Job &job)
+                               { return job.id == jobId; });
+        if (it != queue.end())
+        {
+            queue.erase(it);
+            return true;
+        }
+    }
+
+    return false;
+}
+
+bool TaskScheduler::isPending(JobId jobId) const
+{
+    if (jobId == 0)
+        return false;
+
+    if (jobId == mRunningJobId)
+        return !mIsRunningJobCancelled;
+
+    for (const auto &queue : mJobQueues)
+    {
+        if (std::any_of(queue.begin(), queue.end(), [jobId](const Job &job)
+                        { return job.id == jobId; }))
+            return true;
+    }
+
+    return false;
+}
+
+void TaskScheduler::requestSlice()
+{
+    QCoreApplication *application = QCoreApplication::instance();
+    if (mIsSliceRequested || !application)
+        return;
+
+    mIsSliceRequested = true;
+    QTimer::singleShot(0, application, [this]()
+                       { runSlice(); });
+}
+
+void TaskScheduler::runSlice()
+{
+    mIsSliceRequested = false;
+
+    // Do not run the jobs from a nested event loop, but resume them once the running slice returns
+    if (mIsRunningSlice)
+    {
+        requestSlice();
+        return;
+    }
+    mIsRunningSlice = true;
+
+    QDeadlineTimer deadline(mSliceBudgetMs);
+
+    for (auto &queue : mJobQueues)
+    {
+        while (!queue.empty())
+        {
+            if (deadline.hasExpired())
+            {
+                // Yield to the event loop and continue in the next slice
+                mIsRunningSlice = false;
+                requestSlice();
+                return;
+            }
+
+            // Take the job out of the queue while its step runs, so the step can schedule or cancel jobs safely
+            Job job = std::move(queue.front());
+            queue.pop_front();
+
+            mRunningJobId = job.id;
+            mIsRunningJobCancelled = false;
+
+            bool hasRemainingWork = true;
+            while (hasRemainingWork && !mIsRunningJobCancelled && !deadline.hasExpired())
+                hasRemainingWork = job.step(deadline);
+
+            mRunningJobId = 0;
+
+            if (mIsRunningJobCancelled)
+                continue;
+
+            if (hasRemainingWork)
+            {
+                // Resume this job first in the next slice
+                queue.push_front(std::move(job));
+                mIsRunningSlice = false;
+                requestSlice();
+                return;
+            }
+
+            if (job.onCompleted)
+                job.onCompleted();
+        }
+    }
+
+    mIsRunningSlice = false;
+}
\ No newline at end of file
@@ -0,0 +1,123 @@
+#pragma once
+
+#include <array>
+#include <deque>
+#include <functional>
+
+#include <QtCore/QDeadlineTimer>
+
+/**
+ * @class TaskScheduler
+ * @brief Singleton cooperative scheduler that runs SDK-bound jobs on the main thread in time-sliced steps
+ * @details The fbsdk must be accessed from the main thread, so long-running work such as collecting scene models
+ *          is split into steps which run in slices of a fixed time budget. Slices are driven by zero-timers,
+ *          so the event loop processes input and paint events between them.
+ *          Jobs run in the order of their priority, and in the order they were scheduled within the same priority.
+ * @note All functions must be called from the main thread.
+ */
+class TaskScheduler
+{
+public:
+    /**
+     * @enum Priority
+     * @brief Priority of a job
+     */
+    enum class Priority
+    {
+        High,   //!< Work the user is waiting for, e.g. the suggestion list being shown
+        Normal, //!< Work the user will likely need soon, e.g. warming caches
+        Low     //!< Background work
+    };
+
+    /// Identifier of a scheduled job, 0 is never used
+    using JobId = unsigned long long;
+
+    /**
+     * @brief A step of a job
+     * @details Called repeatedly until it returns false. A step may process multiple items while the deadline has not expired.
+     * @param deadline The deadline of the current slice
+     * @return true if work remains, false if the job is completed
+     */
+    using JobStep = std::function<bool(const QDeadlineTimer &deadline)>;
+
+    /**
+     * @brief Get the singleton instance of the TaskScheduler
+     * @return Reference to the singleton instance
+     */
+    static TaskScheduler &getInstance()
+    {
+        static TaskScheduler instance;
+        return instance;
+    }
+
+    /**
+     * @brief Schedule a job
+     * @param step The step function of the job
+     * @param priority The priority of the job
+     * @param onCompleted The callback called once when the job is completed, not called if the job is cancelled
+     * @return The identifier of the job to cancel it
+     */
+    JobId schedule(JobStep step, Priority priority = Priority::Normal, std::function<void()> onCompleted = nullptr);
+
+    /**
+     * @brief Cancel a job
+     * @param jobId The identifier of the job
+     * @return true if the job was scheduled and is cancelled, false if it is unknown or already completed
+     * @note A job can cancel itself from its step function.
+     */
+    bool cancel(JobId jobId);
+
+    /**
+     * @brief Check if a job is scheduled and not completed yet
+     * @param jobId The identifier of the job
+     * @return true if the job is pending, false otherwise
+     */
+    bool isPending(JobId jobId) const;
+
+    /**
+     * @brief Set the time budget of one slice
+     * @param budgetMs The time budget in milliseconds
+     */
+    void setSliceBudgetMs(int budgetMs) { mSliceBudgetMs = budgetMs; }
+
+private:
+    /// @cond
+    TaskScheduler() = default;
+    TaskScheduler(const TaskScheduler &) = delete;
+    TaskScheduler &operator=(const TaskScheduler &) = delete;
+    /// @endcond
+
+    /**
+     * @brief Start a zero-timer for the next slice if not started yet
+     */
+    void requestSlice();
+
+    /**
+     * @brief Run the steps of the pending jobs in priority order until the slice budget runs out
+     * @details A slice started by a nested event loop of a step or a completion callback, e.g. a modal dialog,
+     *          only requests another slice, so the running job keeps its state.
+     */
+    void runSlice();
+
+private:
+    /**
+     * @struct Job
+     * @brief A scheduled job
+     */
+    struct Job
+    {
+        JobId id = 0;                       //!< Identifier of the job
+        JobStep step;                       //!< Step function of the job
+        std::function<void()> onCompleted; //!< Callback called when the job is completed
+    };
+
+    static constexpr int priorityCount = 3; //!< Number of Priority values
+
+    std::array<std::deque<Job>, priorityCount> mJobQueues; //!< Pending jobs for each priority
+    JobId mNextJobId = 1;                                   //!< Identifier of the next scheduled job
+    JobId mRunningJobId = 0;                                //!< Identifier of the job whose step is running, 0 if none
+    bool mIsRunningJobCancelled = false;                    //!< Flag indicating that the running job cancelled itself
+    bool mIsSliceRequested = false;                         //!< Flag to coalesce the slice requests into one zero-timer
+    bool mIsRunningSlice = false;                           //!< Flag indicating that a slice is running, to detect the nested event loops
+    int mSliceBudgetMs = 8;                                 //!< Time budget of one slice in milliseconds
+};
\ No newline at end of file
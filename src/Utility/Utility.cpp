@@ -1,8 +1,12 @@
 #include "Utility.h"
 
+#include <atomic>
 #include <functional>
 #include <set>
+#include <unordered_map>
+#include <vector>
 
+#include <QtCore/QElapsedTimer>
 #include <QtCore/QString>
 #include <QtWidgets/QApplication>
 #include <QtWidgets/QWidget>
@@ -49,8 +53,21 @@ QList<QDockWidget *> getDockedConstraintNavigators(QMainWindow *mainwindow)
     return foundNavigators;
 }
 
-FBConstraintRelation *getConstraintRelationFromName(std::string name)
+/// Name-to-relation hash index for getConstraintRelationFromName, rebuilt from the scene when invalidated
+static std::unordered_map<std::string, HdlFBPlugTemplate<FBConstraintRelation>> constraintRelationNameIndex;
+
+/// Flag indicating that constraintRelationNameIndex must be rebuilt
+static std::atomic<bool> isConstraintRelationNameIndexInvalid = true;
+
+/**
+ * @brief Helper function to rebuild the name-to-relation hash index from the relation constraints in the scene
+ */
+static void rebuildConstraintRelationNameIndex()
 {
+    // Clear the flag first, so changes notified while rebuilding invalidate the index again
+    isConstraintRelationNameIndexInvalid = false;
+    constraintRelationNameIndex.clear();
+
     // Iterate over all constraints in the scene
     for (int i = 0; i < FBSystem().Scene->Constraints.GetCount(); ++i)
     {
@@ -59,14 +76,116 @@ FBConstraintRelation *getConstraintRelationFromName(std::string name)
         if (FBIS(constraint, FBConstraintRelation))
         {
             FBConstraintRelation *relation = (FBConstraintRelation *)constraint;
-            if (std::string(relation->Name.AsString()) == name)
-            {
-                return relation; // Return the matching relation
-            }
+
+            // Keep the first relation for the same name, as the linear search did
+            constraintRelationNameIndex.emplace(relation->Name.AsString(), relation);
+        }
+    }
+}
+
+FBConstraintRelation *getConstraintRelationFromName(std::string name)
+{
+    if (isConstraintRelationNameIndexInvalid)
+        rebuildConstraintRelationNameIndex();
+
+    auto it = constraintRelationNameIndex.find(name);
+    if (it == constraintRelationNameIndex.end())
+        return nullptr; // Return nullptr if no matching relation is found
+
+    // The relation might have been deleted or renamed without notification, so verify the entry before returning it
+    if (!it->second.Ok() || name != it->second->Name.AsString())
+    {
+        rebuildConstraintRelationNameIndex();
+
+        it = constraintRelationNameIndex.find(name);
+        if (it == constraintRelationNameIndex.end() || !it->second.Ok())
+            return nullptr;
+    }
+
+    return (FBConstraintRelation *)it->second; // Return the matching relation
+}
+
+void invalidateConstraintRelationNameIndex()
+{
+    isConstraintRelationNameIndexInvalid = true;
+}
+
+/**
+ * @brief Helper function to find a relation constraint by name with a linear scan of the scene, as done before the hash index
+ * @param name The name of the relation constraint
+ * @return Pointer to the first FBConstraintRelation with the name, otherwise nullptr
+ */
+static FBConstraintRelation *findConstraintRelationByScan(const std::string &name)
+{
+    for (int i = 0; i < FBSystem().Scene->Constraints.GetCount(); ++i)
+    {
+        FBConstraint *constraint = FBSystem().Scene->Constraints[i];
+        if (FBIS(constraint, FBConstraintRelation) && name == constraint->Name.AsString())
+            return (FBConstraintRelation *)constraint;
+    }
+
+    return nullptr;
+}
+
+void traceConstraintRelationLookupReport()
+{
+    // Number of lookups averaged for each measurement
+    constexpr int lookupRepeatCount = 1000;
+
+    static const int relationPositions[] = {10, 100, 1000};
+
+    // Collect the names of the relation constraints in the scene order
+    std::vector<std::string> relationNames;
+    for (int i = 0; i < FBSystem().Scene->Constraints.GetCount(); ++i)
+    {
+        FBConstraint *constraint = FBSystem().Scene->Constraints[i];
+        if (FBIS(constraint, FBConstraintRelation))
+            relationNames.push_back(constraint->Name.AsString());
+    }
+
+    auto measureLookupNs = [](const std::function<FBConstraintRelation *()> &lookup)
+    {
+        QElapsedTimer timer;
+        timer.start();
+        for (int i = 0; i < lookupRepeatCount; ++i)
+            lookup();
+        return timer.nsecsElapsed() / static_cast<double>(lookupRepeatCount);
+    };
+
+    // The first lookup after a relation constraint is added, deleted or renamed pays for the rebuild
+    QElapsedTimer rebuildTimer;
+    rebuildTimer.start();
+    rebuildConstraintRelationNameIndex();
+    const double rebuildMs = rebuildTimer.nsecsElapsed() / 1e6;
+
+    DIALOG_DEBUG_START;
+    DIALOG_DEBUG_MESSAGE("Relation constraint lookup by name (%zu relation constraints in the scene):", relationNames.size());
+    DIALOG_DEBUG_MESSAGE("Index rebuild: %.3f ms", rebuildMs);
+
+    for (int position : relationPositions)
+    {
+        if (position > static_cast<int>(relationNames.size()))
+        {
+            DIALOG_DEBUG_MESSAGE("Relation constraint #%d: skipped, the scene has fewer relation constraints", position);
+            continue;
         }
+
+        const std::string &name = relationNames[position - 1];
+        auto lookupByIndex = [&name]()
+        {
+            return getConstraintRelationFromName(name);
+        };
+        auto lookupByScan = [&name]()
+        {
+            return findConstraintRelationByScan(name);
+        };
+
+        const double indexNs = measureLookupNs(lookupByIndex);
+        const double scanNs = measureLookupNs(lookupByScan);
+        DIALOG_DEBUG_MESSAGE("Relation constraint #%d: hash index %.1f ns, linear scan %.1f ns per lookup", position, indexNs, scanNs);
     }
 
-    return nullptr; // Return nullptr if no matching relation is found
+    DIALOG_DEBUG_END_NOTFAILURE;
 }
 
 bool checkMacroRecursivity(std::string currentRelationName, std::string macroCandidateName)
@@ -0,0 +1,98 @@
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <limits>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+#include <QtCore/QElapsedTimer>
+
+/// Number of lookups in each run, so a run is long enough to be timed
+constexpr int lookupCount = 10000;
+
+/// Number of times each measurement is repeated, the fastest run is reported
+constexpr int repeatCount = 5;
+
+/**
+ * @brief Generate relation constraint names shaped like those of a rigged MotionBuilder scene
+ * @param count The number of names
+ * @return The names, in the scene order
+ */
+static std::vector<std::string> generateRelationNames(int count)
+{
+    static const char *const purposes[] = {"FootRoll", "Twist", "Blend", "Aim", "Switch"};
+
+    std::vector<std::string> names;
+    for (int i = 0; i < count; ++i)
+        names.push_back(std::string("Actor") + std::to_string(i / 50) + "_" + purposes[i % 5] + "_Relation" + std::to_string(i));
+    return names;
+}
+
+/**
+ * @brief Measure the lookups of a name and print the fastest run
+ * @param label The label of the measurement
+ * @param lookup The lookup to measure, returning the position of the name or -1 if not found
+ */
+static void measure(const char *label, const std::function<int()> &lookup)
+{
+    qint64 bestNs = std::numeric_limits<qint64>::max();
+    int position = -1;
+
+    for (int run = 0; run < repeatCount; ++run)
+    {
+        QElapsedTimer timer;
+        timer.start();
+
+        for (int i = 0; i < lookupCount; ++i)
+            position = lookup();
+
+        bestNs = std::min(bestNs, timer.nsecsElapsed());
+    }
+
+    std::printf("%-36s %9.1f ns per lookup, found at %d\n", label, bestNs / static_cast<double>(lookupCount), position);
+}
+
+/**
+ * @brief Compare the hash index with the linear scan of the names which the index replaced
+ * @param names The names in the scene order
+ * @param name The name to look up
+ * @param label The label of the name
+ */
+static void compareLookups(const std::vector<std::string> &names, const std::string &name, const char *label)
+{
+    // Build the index like rebuildConstraintRelationNameIndex, keeping the first of the duplicate names
+    std::unordered_map<std::string, int> index;
+    for (int i = 0; i < static_cast<int>(names.size()); ++i)
+        index.emplace(names[i], i);
+
+    std::printf("\n%s\n", label);
+
+    measure("  hash index", [&index, &name]()
+            {
+                auto it = index.find(name);
+                return it == index.end() ? -1 : it->second; });
+    measure("  linear scan", [&names, &name]()
+            {
+                for (int i = 0; i < static_cast<int>(names.size()); ++i)
+                {
+                    if (name == names[i].c_str())
+                        return i;
+                }
+                return -1; });
+}
+
+int main()
+{
+    for (int count : {10, 100, 1000})
+    {
+        const std::vector<std::string> names = generateRelationNames(count);
+        std::printf("\n=== %d relation constraints ===\n", count);
+
+        compareLookups(names, names.front(), "first name");
+        compareLookups(names, names.back(), "last name");
+        compareLookups(names, "Missing_Relation", "missing name");
+    }
+
+    return 0;
+}
\ No newline at end of file
@@ -0,0 +1,113 @@
+#include <algorithm>
+#include <cstdio>
+#include <functional>
+#include <limits>
+
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QString>
+#include <QtCore/QVector>
+
+#include "ModelQuery.h"
+
+/// Number of times each measurement is repeated, the fastest run is reported
+constexpr int repeatCount = 5;
+
+/**
+ * @brief Generate long model names shaped like the characters and props of a MotionBuilder scene
+ * @param actorCount The number of namespaces
+ * @return The names, about 300 per namespace
+ */
+static QVector<QString> generateModelNames(int actorCount)
+{
+    static const char *const sides[] = {"Left", "Right", "_L_", "_R_"};
+    static const char *const parts[] = {"Hand", "Foot", "Arm", "ForeArm", "UpLeg", "Leg", "Shoulder"};
+    static const char *const fingers[] = {"Thumb", "Index", "Middle", "Ring", "Pinky"};
+
+    QVector<QString> names;
+    for (int actor = 0; actor < actorCount; ++actor)
+    {
+        const QString nameSpace = QString("Actor%1:").arg(actor, 2, 10, QChar('0'));
+        for (const char *side : sides)
+        {
+            for (const char *part : parts)
+            {
+                names.push_back(nameSpace + side + part);
+                for (const char *finger : fingers)
+                {
+                    for (int joint = 1; joint <= 2; ++joint)
+                        names.push_back(nameSpace + side + part + finger + QString::number(joint));
+                }
+            }
+        }
+        names.push_back(nameSpace + "Reference");
+        names.push_back(nameSpace + "Hips");
+    }
+    return names;
+}
+
+/**
+ * @brief Measure a matcher over all the names and print the fastest run
+ * @param label The label of the measurement
+ * @param names The names to match
+ * @param matches The matcher to measure
+ */
+static void measure(const char *label, const QVector<QString> &names, const std::function<bool(const QString &)> &matches)
+{
+    qint64 bestNs = std::numeric_limits<qint64>::max();
+    int matchCount = 0;
+
+    for (int run = 0; run < repeatCount; ++run)
+    {
+        QElapsedTimer timer;
+        timer.start();
+
+        matchCount = 0;
+        for (const QString &name : names)
+        {
+            if (matches(name))
+                matchCount++;
+        }
+
+        bestNs = std::min(bestNs, timer.nsecsElapsed());
+    }
+
+    std::printf("%-44s %9.3f ms %8d matches\n", label, bestNs / 1e6, matchCount);
+}
+
+/**
+ * @brief Compare a pattern with and without the literal prefilter against a plain substring search
+ * @param names The names to match
+ * @param substring The substring which the pattern requires
+ * @param pattern The pattern text
+ * @param isGlob true if the pattern is a glob, false if it is a regular expression
+ */
+static void comparePattern(const QVector<QString> &names, const QString &substring, const QString &pattern, bool isGlob)
+{
+    const ModelQueryPattern compiled = compileModelQueryPattern(pattern, isGlob);
+
+    std::printf("\n%s \"%s\", required literals \"%s\"\n", isGlob ? "glob" : "regex", qPrintable(pattern),
+                qPrintable(compiled.requiredLiterals.join("\", \"")));
+
+    measure("  substring", names, [&substring](const QString &name)
+            { return name.contains(substring, Qt::CaseInsensitive); });
+    measure("  pattern with the literal prefilter", names, [&compiled](const QString &name)
+            { return compiled.matches(name); });
+    measure("  pattern without the literal prefilter", names, [&compiled](const QString &name)
+            { return compiled.regex.match(name).hasMatch(); });
+}
+
+int main()
+{
+    for (int actorCount : {10, 100})
+    {
+        const QVector<QString> names = generateModelNames(actorCount);
+        std::printf("\n=== %d names ===\n", static_cast<int>(names.size()));
+
+        comparePattern(names, "_L_", "*_L_*", true);
+        comparePattern(names, "Index", "*Index[12]", true);
+        comparePattern(names, "Index", "Left\\w*Index\\d", false);
+        comparePattern(names, "Pinky", "(Hand|Foot)Pinky", false);
+    }
+
+    return 0;
+}
\ No newline at end of file
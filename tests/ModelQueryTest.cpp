@@ -0,0 +1,182 @@
+#include <vector>
+
+#include <QtCore/QString>
+#include <QtCore/QStringList>
+
+#include "ModelQuery.h"
+#include "TestSupport.h"
+
+/**
+ * @brief Get the required literals of a compiled pattern
+ * @param pattern The pattern text
+ * @param isGlob true if the pattern is a glob, false if it is a regular expression
+ * @return The required literals, longest first
+ */
+static QStringList requiredLiterals(const QString &pattern, bool isGlob)
+{
+    return compileModelQueryPattern(pattern, isGlob).requiredLiterals;
+}
+
+/**
+ * @brief Match a text term against the tokens of a name, with the character positions computed as SuggestionProvider does
+ * @param text The text of the term
+ * @param name The name to match
+ * @param nameStart The index of the first character which can start a match
+ * @return How the text matches the tokens
+ */
+static ModelQueryTerm::TokenMatch matchTokens(const QString &text, const QString &name, int nameStart = 0)
+{
+    ModelQueryTerm term;
+    term.text = text;
+    term.foldedText = text.toCaseFolded();
+
+    const quint64 characterMask = computeCharacterMask(name);
+    std::vector<quint64> positionMasks;
+    appendCharacterPositions(name, characterMask, positionMasks);
+
+    const CharacterPositions positions{name, characterMask, positionMasks.data()};
+    return term.matchTokens(positions, computeTokenStartMask(name), nameStart);
+}
+
+/**
+ * @brief Check the literals extracted from the regular expressions
+ */
+static void testRegexLiterals()
+{
+    // Quantifiers drop the optional character, but not a repeated one
+    CHECK((requiredLiterals("hand_?l", false) == QStringList{"hand", "l"}));
+    CHECK((requiredLiterals("colou*r", false) == QStringList{"colo", "r"}));
+    CHECK((requiredLiterals("ab+c", false) == QStringList{"ab", "c"}));
+    CHECK((requiredLiterals("a{2}bc", false) == QStringList{"bc"}));
+    CHECK((requiredLiterals("Left.*Index", false) == QStringList{"Index", "Left"}));
+
+    // Groups are skipped, and may be optional
+    CHECK((requiredLiterals("left(hand)?index", false) == QStringList{"index", "left"}));
+    CHECK((requiredLiterals("(arm)leg", false) == QStringList{"leg"}));
+
+    // Escapes break the runs, including the escaped quantifiers
+    CHECK((requiredLiterals("finger\\d+", false) == QStringList{"finger"}));
+    CHECK((requiredLiterals("\\.end$", false) == QStringList{"end"}));
+    CHECK((requiredLiterals("a\\*b", false) == QStringList{"a", "b"}));
+
+    // A closing bracket first in a character class is part of the class
+    CHECK((requiredLiterals("[]a]bc", false) == QStringList{"bc"}));
+    CHECK((requiredLiterals("[^]a]bc", false) == QStringList{"bc"}));
+
+    // Alternations yield no literals
+    CHECK(requiredLiterals("(left|right)hand", false).isEmpty());
+    CHECK(requiredLiterals("hand|foot", false).isEmpty());
+
+    // Invalid patterns yield no literals
+    const ModelQueryPattern invalid = compileModelQueryPattern("(hand", false);
+    CHECK(!invalid.regex.isValid());
+    CHECK(invalid.requiredLiterals.isEmpty());
+}
+
+/**
+ * @brief Check the literals extracted from the globs
+ */
+static void testGlobLiterals()
+{
+    CHECK((requiredLiterals("*_L_*", true) == QStringList{"_L_"}));
+    CHECK((requiredLiterals("ab?cd", true) == QStringList{"ab", "cd"}));
+    CHECK((requiredLiterals("finger[0-4]", true) == QStringList{"finger"}));
+
+    // A closing bracket first in a character set is part of the set
+    CHECK((requiredLiterals("[]a]bone*", true) == QStringList{"bone"}));
+    CHECK((requiredLiterals("[!]x]yz", true) == QStringList{"yz"}));
+}
+
+/**
+ * @brief Check that the literal prefilter does not change the result of the patterns
+ */
+static void testPatternMatches()
+{
+    const ModelQueryPattern side = compileModelQueryPattern("*_L_*", true);
+    CHECK(side.matches("Arm_L_01"));
+    CHECK(side.matches("arm_l_01"));
+    CHECK(!side.matches("Arm_R_01"));
+
+    const ModelQueryPattern bracket = compileModelQueryPattern("[]a]bone*", true);
+    CHECK(bracket.matches("]bone1"));
+    CHECK(bracket.matches("abone2"));
+    CHECK(!bracket.matches("bone"));
+
+    const ModelQueryPattern finger = compileModelQueryPattern("left(hand)?index\\d", false);
+    CHECK(finger.matches("LeftIndex1"));
+    CHECK(finger.matches("Actor01:LeftHandIndex2"));
+    CHECK(!finger.matches("LeftHandIndex"));
+}
+
+/**
+ * @brief Check the token matching with the precomputed character positions
+ */
+static void testTokenMatches()
+{
+    CHECK(matchTokens("hand", "LeftHandIndex1") == ModelQueryTerm::TokenMatch::TokenStart);
+    CHECK(matchTokens("lefth", "LeftHandIndex1") == ModelQueryTerm::TokenMatch::TokenStart);
+    CHECK(matchTokens("lhi", "LeftHandIndex1") == ModelQueryTerm::TokenMatch::Acronym);
+    CHECK(matchTokens("lhand", "LeftHandIndex1") == ModelQueryTerm::TokenMatch::Acronym);
+    CHECK(matchTokens("andi", "LeftHandIndex1") == ModelQueryTerm::TokenMatch::None);
+    CHECK(matchTokens("lhx", "LeftHandIndex1") == ModelQueryTerm::TokenMatch::None);
+
+    // Name-only terms skip the namespace
+    CHECK(matchTokens("actor", "Actor01:Hand") == ModelQueryTerm::TokenMatch::TokenStart);
+    CHECK(matchTokens("actor", "Actor01:Hand", 8) == ModelQueryTerm::TokenMatch::None);
+    CHECK(matchTokens("hand", "Actor01:Hand", 8) == ModelQueryTerm::TokenMatch::TokenStart);
+
+    // Separators share their bits with other characters, so they are compared with the name
+    CHECK(matchTokens("01:h", "Actor01:Hand") == ModelQueryTerm::TokenMatch::TokenStart);
+    CHECK(matchTokens("x:", QString("x") + QChar(0x00AA) + "y") == ModelQueryTerm::TokenMatch::None);
+}
+
+/**
+ * @brief Check that the terms match the long names without building them for the terms without a separator
+ */
+static void testTermMatches()
+{
+    ModelQueryTerm hand;
+    hand.text = "hand";
+    CHECK(hand.matches("Actor01", "LeftHand"));
+    CHECK(!hand.matches("Actor01", "LeftFoot"));
+
+    ModelQueryTerm actor;
+    actor.text = "actor";
+    CHECK(actor.matches("Actor01", "LeftFoot"));
+    CHECK(!actor.matches("", "LeftFoot"));
+
+    // Terms with a separator match across the namespace and the name
+    ModelQueryTerm scoped;
+    scoped.text = "01:left";
+    CHECK(scoped.matches("Actor01", "LeftFoot"));
+    CHECK(!scoped.matches("Actor02", "LeftFoot"));
+
+    // The long name starts with the namespace and ends with the name
+    ModelQueryTerm startsWithActor;
+    startsWithActor.text = "actor";
+    startsWithActor.isAnchoredStart = true;
+    CHECK(startsWithActor.matches("Actor01", "LeftFoot"));
+
+    ModelQueryTerm endsWith01;
+    endsWith01.text = "01";
+    endsWith01.isAnchoredEnd = true;
+    CHECK(!endsWith01.matches("Actor01", "LeftFoot"));
+    CHECK(endsWith01.matches("Actor02", "Spine01"));
+
+    ModelQueryTerm scopedRegex;
+    scopedRegex.kind = ModelQueryTerm::Kind::Regex;
+    scopedRegex.pattern = compileModelQueryPattern("r01:left", false);
+    CHECK(scopedRegex.matches("Actor01", "LeftFoot"));
+    CHECK(!scopedRegex.matches("Actor01", "RightFoot"));
+}
+
+int main()
+{
+    testRegexLiterals();
+    testGlobLiterals();
+    testPatternMatches();
+    testTokenMatches();
+    testTermMatches();
+
+    return gFailedCheckCount == 0 ? 0 : 1;
+}
\ No newline at end of file
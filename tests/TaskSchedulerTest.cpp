@@ -0,0 +1,250 @@
+#include <algorithm>
+#include <vector>
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QDeadlineTimer>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QTimer>
+
+#include "TaskScheduler.h"
+#include "TestSupport.h"
+
+/**
+ * @brief Check that the jobs run by priority, and in the order they were scheduled within the same priority
+ */
+static void testPriorityOrder()
+{
+    TaskScheduler &scheduler = TaskScheduler::getInstance();
+    std::vector<int> order;
+
+    auto scheduleRecorder = [&scheduler, &order](int label, TaskScheduler::Priority priority)
+    {
+        scheduler.schedule([&order, label](const QDeadlineTimer &)
+                           {
+                               order.push_back(label);
+                               return false; },
+                           priority);
+    };
+
+    // Scheduled in the reverse order of their expected run
+    scheduleRecorder(4, TaskScheduler::Priority::Low);
+    scheduleRecorder(2, TaskScheduler::Priority::Normal);
+    scheduleRecorder(1, TaskScheduler::Priority::High);
+    scheduleRecorder(3, TaskScheduler::Priority::Normal);
+
+    CHECK(processEventsUntil([&order]()
+                             { return order.size() == 4; }));
+    CHECK((order == std::vector<int>{1, 2, 3, 4}));
+}
+
+/**
+ * @brief Check that a slice stops running steps once its budget is spent, and yields to the event loop
+ */
+static void testSliceBudget()
+{
+    constexpr int sliceBudgetMs = 5;
+    constexpr int stepDurationMs = 1;
+    constexpr int stepCount = 40;
+
+    TaskScheduler &scheduler = TaskScheduler::getInstance();
+    scheduler.setSliceBudgetMs(sliceBudgetMs);
+
+    // Count the events processed while the job runs, to check that the slices yield between them
+    int timerTickCount = 0;
+    QTimer ticker;
+    QObject::connect(&ticker, &QTimer::timeout, [&timerTickCount]()
+                     { timerTickCount++; });
+    ticker.start(0);
+
+    // Each slice creates its own deadline, so the steps are grouped into slices by their deadline
+    std::vector<int> stepCountsPerSlice;
+    qint64 lastDeadline = -1;
+    int completedStepCount = 0;
+    bool isCompleted = false;
+
+    auto step = [&](const QDeadlineTimer &deadline)
+    {
+        if (deadline.deadlineNSecs() != lastDeadline)
+        {
+            lastDeadline = deadline.deadlineNSecs();
+            stepCountsPerSlice.push_back(0);
+        }
+        stepCountsPerSlice.back()++;
+
+        QElapsedTimer busyTimer;
+        busyTimer.start();
+        while (!busyTimer.hasExpired(stepDurationMs))
+        {
+        }
+
+        return ++completedStepCount < stepCount;
+    };
+    auto onCompleted = [&isCompleted]()
+    {
+        isCompleted = true;
+    };
+    scheduler.schedule(step, TaskScheduler::Priority::Normal, onCompleted);
+
+    CHECK(processEventsUntil([&isCompleted]()
+                             { return isCompleted; }));
+    ticker.stop();
+
+    // A step takes at least stepDurationMs, and no step starts after the deadline has expired
+    CHECK(completedStepCount == stepCount);
+    CHECK(stepCountsPerSlice.size() >= static_cast<size_t>(stepCount * stepDurationMs / sliceBudgetMs));
+    CHECK(*std::max_element(stepCountsPerSlice.begin(), stepCountsPerSlice.end()) <= sliceBudgetMs / stepDurationMs);
+    CHECK(timerTickCount > 0);
+
+    scheduler.setSliceBudgetMs(8);
+}
+
+/**
+ * @brief Check that a job can cancel itself from its step, and that its completion callback is not called
+ */
+static void testSelfCancel()
+{
+    TaskScheduler &scheduler = TaskScheduler::getInstance();
+
+    TaskScheduler::JobId jobId = 0;
+    int stepCallCount = 0;
+    bool isCompletionCalled = false;
+    bool isPendingAfterCancel = true;
+    bool isCancelAccepted = false;
+
+    auto step = [&](const QDeadlineTimer &)
+    {
+        if (++stepCallCount == 3)
+        {
+            isCancelAccepted = scheduler.cancel(jobId);
+            isPendingAfterCancel = scheduler.isPending(jobId);
+        }
+
+        // The job still has work, so only the cancellation stops it
+        return true;
+    };
+    auto onCompleted = [&isCompletionCalled]()
+    {
+        isCompletionCalled = true;
+    };
+    jobId = scheduler.schedule(step, TaskScheduler::Priority::High, onCompleted);
+
+    CHECK(scheduler.isPending(jobId));
+    CHECK(processEventsUntil([&scheduler, &jobId]()
+                             { return !scheduler.isPending(jobId); }));
+
+    // Let a few more slices run, in case the cancelled job was queued again
+    bool isFollowingJobDone = false;
+    scheduler.schedule([&isFollowingJobDone](const QDeadlineTimer &)
+                       {
+                           isFollowingJobDone = true;
+                           return false; },
+                       TaskScheduler::Priority::Low);
+    CHECK(processEventsUntil([&isFollowingJobDone]()
+                             { return isFollowingJobDone; }));
+
+    CHECK(isCancelAccepted);
+    CHECK(!isPendingAfterCancel);
+    CHECK(stepCallCount == 3);
+    CHECK(!isCompletionCalled);
+    CHECK(!scheduler.cancel(jobId));
+}
+
+/**
+ * @brief Check that a job cancelled before it runs never runs, and that its completion callback is not called
+ */
+static void testCancelPendingJob()
+{
+    TaskScheduler &scheduler = TaskScheduler::getInstance();
+
+    int stepCallCount = 0;
+    bool isCompletionCalled = false;
+    int completionCallCount = 0;
+
+    auto cancelledStep = [&stepCallCount](const QDeadlineTimer &)
+    {
+        stepCallCount++;
+        return false;
+    };
+    auto onCancelledCompleted = [&isCompletionCalled]()
+    {
+        isCompletionCalled = true;
+    };
+    const TaskScheduler::JobId cancelledJobId = scheduler.schedule(cancelledStep, TaskScheduler::Priority::High, onCancelledCompleted);
+
+    auto step = [](const QDeadlineTimer &)
+    {
+        return false;
+    };
+    auto onCompleted = [&completionCallCount]()
+    {
+        completionCallCount++;
+    };
+    const TaskScheduler::JobId jobId = scheduler.schedule(step, TaskScheduler::Priority::Low, onCompleted);
+
+    CHECK(scheduler.cancel(cancelledJobId));
+    CHECK(!scheduler.isPending(cancelledJobId));
+
+    CHECK(processEventsUntil([&scheduler, jobId]()
+                             { return !scheduler.isPending(jobId); }));
+
+    CHECK(stepCallCount == 0);
+    CHECK(!isCompletionCalled);
+    CHECK(completionCallCount == 1);
+    CHECK(!scheduler.cancel(cancelledJobId));
+    CHECK(!scheduler.cancel(0));
+}
+
+/**
+ * @brief Check that a slice started by a nested event loop of a step does not run the other jobs
+ */
+static void testNestedEventLoop()
+{
+    constexpr int nestedLoopDurationMs = 50;
+
+    TaskScheduler &scheduler = TaskScheduler::getInstance();
+
+    bool isOtherJobDone = false;
+    bool isOtherJobDoneInNestedLoop = false;
+    bool isCompletionCalled = false;
+
+    auto otherStep = [&isOtherJobDone](const QDeadlineTimer &)
+    {
+        isOtherJobDone = true;
+        return false;
+    };
+    auto step = [&](const QDeadlineTimer &)
+    {
+        // Run a nested event loop like a modal dialog, after scheduling a job of a higher priority
+        scheduler.schedule(otherStep, TaskScheduler::Priority::High);
+
+        QElapsedTimer nestedLoopTimer;
+        nestedLoopTimer.start();
+        processEventsUntil([&nestedLoopTimer]()
+                           { return nestedLoopTimer.hasExpired(nestedLoopDurationMs); });
+
+        isOtherJobDoneInNestedLoop = isOtherJobDone;
+        return false;
+    };
+    auto onCompleted = [&isCompletionCalled]()
+    {
+        isCompletionCalled = true;
+    };
+    scheduler.schedule(step, TaskScheduler::Priority::Normal, onCompleted);
+
+    CHECK(processEventsUntil([&isOtherJobDone, &isCompletionCalled]()
+                             { return isOtherJobDone && isCompletionCalled; }));
+    CHECK(!isOtherJobDoneInNestedLoop);
+}
+
+int main(int argc, char *argv[])
+{
+    QCoreApplication application(argc, argv);
+
+    testPriorityOrder();
+    testSliceBudget();
+    testSelfCancel();
+    testCancelPendingJob();
+    testNestedEventLoop();
+
+    return gFailedCheckCount == 0 ? 0 : 1;
+}
\ No newline at end of file
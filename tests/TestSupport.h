@@ -0,0 +1,50 @@
+#pragma once
+
+#include <cstdio>
+#include <functional>
+
+#include <QtCore/QCoreApplication>
+#include <QtCore/QElapsedTimer>
+#include <QtCore/QEventLoop>
+
+/// Number of the failed checks, returned by the test executables
+inline int gFailedCheckCount = 0;
+
+/**
+ * @brief Report a failed check without stopping the test, so one run lists all the failures
+ * @param isPassed The result of the check
+ * @param expression The checked expression
+ * @param file The source file of the check
+ * @param line The source line of the check
+ */
+inline void reportCheck(bool isPassed, const char *expression, const char *file, int line)
+{
+    if (isPassed)
+        return;
+
+    gFailedCheckCount++;
+    std::fprintf(stderr, "%s(%d): check failed: %s\n", file, line, expression);
+}
+
+#define CHECK(expression) reportCheck(static_cast<bool>(expression), #expression, __FILE__, __LINE__)
+
+/**
+ * @brief Process the events until a condition is met or a timeout expires
+ * @param condition The condition to wait for
+ * @param timeoutMs The timeout in milliseconds
+ * @return true if the condition is met, false if the timeout expired
+ */
+inline bool processEventsUntil(const std::function<bool()> &condition, int timeoutMs = 5000)
+{
+    QElapsedTimer timer;
+    timer.start();
+
+    while (!condition())
+    {
+        if (timer.hasExpired(timeoutMs))
+            return false;
+
+        QCoreApplication::processEvents(QEventLoop::AllEvents, 10);
+    }
+    return true;
+}
\ No newline at end of file